@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * Avatar lookup: the prepared SELECT on chatlist_map against the
+ * memory-mapped AvatarIndex, at 100k chats by default. Also times the
+ * index rebuild after an avatar change, alone and for 20 changes grouped
+ * in one transaction, and mapping a fresh index, and checks that both
+ * paths agree on every id looked up.
+ *
+ * Usage: auxdb_avatar_bench [iterations] [chats]
+ */
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QLoggingCategory>
+
+#include "auxdatabase.h"
+#include "avatarindex.h"
+#include "benchutil.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    int iterations = argc > 1 ? QString(argv[1]).toInt() : 100000;
+    int chats = argc > 2 ? QString(argv[2]).toInt() : 100000;
+
+    QLoggingCategory::setFilterRules("auxdb=false\navatarMapTable=false\navatarIndex=false");
+
+    QTextStream out(stdout);
+    QTemporaryDir tmp;
+    AuxDatabase db(tmp.path(), tmp.path());
+    AvatarMapTable *table = db.getAvatarMapTable();
+    if (!table) {
+        qFatal("Cannot open auxdb");
+    }
+
+    // Every third chat has no avatar, like chats that only ever had an
+    // unread count stored
+    QVector<QPair<qint64, QString>> entries;
+    for (int i = 0; i < chats; ++i) {
+        qint64 id = i % 2 ? -(1000000000000LL + i) : qint64(i) + 1;
+        entries.append(qMakePair(id, i % 3 ? QString("/home/phablet/.cache/avatars/%1.jpg").arg(id) : QString()));
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    table->setAvatarMapEntries(entries);
+    out << chats << " chats, bulk insert + index build: " << timer.elapsed() << " ms\n";
+    out.flush();
+
+    // Half the lookups miss, as for chats without an avatar
+    QRandomGenerator random(42);
+    QVector<qint64> ids(iterations);
+    for (qint64 &id : ids) {
+        id = entries.at(random.bounded(chats)).first + (random.bounded(2) ? 0 : 7);
+    }
+
+    BenchStats select, index, open, rebuild, grouped;
+    qint64 checksum = 0;
+    for (qint64 id : ids) {
+        timer.restart();
+        checksum += table->getAvatarPathbyId(id).size();
+        select.add(timer.nsecsElapsed());
+    }
+
+    AvatarIndex avatars;
+    timer.restart();
+    if (!avatars.open(db.avatarIndexPath())) {
+        qFatal("Cannot map avatar index");
+    }
+    open.add(timer.nsecsElapsed());
+
+    for (qint64 id : ids) {
+        timer.restart();
+        checksum -= avatars.lookup(id).size();
+        index.add(timer.nsecsElapsed());
+    }
+
+    int mismatches = 0;
+    for (qint64 id : ids) {
+        if (table->getAvatarPathbyId(id) != avatars.lookup(id)) {
+            ++mismatches;
+        }
+    }
+
+    // A single avatar change rewrites the whole index; the next open()
+    // picks up the new file
+    for (int i = 0; i < 20; ++i) {
+        timer.restart();
+        table->setAvatarMapEntry(entries.at(i).first, QString("/tmp/changed-%1.jpg").arg(i));
+        rebuild.add(timer.nsecsElapsed());
+
+        timer.restart();
+        avatars.open(db.avatarIndexPath());
+        open.add(timer.nsecsElapsed());
+        if (avatars.lookup(entries.at(i).first) != QString("/tmp/changed-%1.jpg").arg(i)) {
+            ++mismatches;
+        }
+    }
+
+    // Grouped changes rewrite the index once, on the outer commit
+    timer.restart();
+    db.transaction();
+    for (int i = 0; i < 20; ++i) {
+        table->setAvatarMapEntry(entries.at(i).first, QString("/tmp/grouped-%1.jpg").arg(i));
+    }
+    db.commit();
+    grouped.add(timer.nsecsElapsed());
+    avatars.open(db.avatarIndexPath());
+    for (int i = 0; i < 20; ++i) {
+        if (avatars.lookup(entries.at(i).first) != QString("/tmp/grouped-%1.jpg").arg(i)) {
+            ++mismatches;
+        }
+    }
+
+    select.print("SELECT path");
+    index.print("AvatarIndex::lookup");
+    open.print("AvatarIndex::open");
+    rebuild.print("set + index rebuild");
+    grouped.print("20 sets in one transaction");
+    out << "index entries " << avatars.size() << ", checksum " << checksum
+        << (mismatches ? QString(", %1 MISMATCHES").arg(mismatches) : QString()) << "\n";
+
+    return mismatches ? 1 : 0;
+}
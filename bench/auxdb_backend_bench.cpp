@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * auxdb storage backend comparison. Built once per backend
+ * (auxdb_backend_bench_qtsql, auxdb_backend_bench_sqlite3); run both.
+ * Reports opening an existing database plus a first lookup in a fresh
+ * process, which is what every push pays, and the per-query cost of the
+ * calls a push makes.
+ *
+ * Usage: auxdb_backend_bench_<backend> [iterations]
+ */
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QProcess>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QLoggingCategory>
+
+#include "auxdatabase.h"
+#include "benchutil.h"
+
+int main(int argc, char *argv[])
+{
+    QElapsedTimer launched;
+    launched.start();
+
+    QCoreApplication app(argc, argv);
+    QLoggingCategory::setFilterRules("auxdb=false\navatarMapTable=false");
+
+    // Child mode: open the database the parent prepared and look one chat up
+    if (argc == 3 && qstrcmp(argv[1], "--startup") == 0) {
+        QElapsedTimer timer;
+        timer.start();
+        AuxDatabase db(QString::fromLocal8Bit(argv[2]), QString());
+        db.getAvatarMapTable()->getAvatarPathbyId(1);
+        QTextStream(stdout) << timer.nsecsElapsed() << " " << launched.nsecsElapsed() << "\n";
+        return 0;
+    }
+
+    int iterations = argc > 1 ? QString(argv[1]).toInt() : 1000;
+    const int chats = 200;
+
+    QTemporaryDir tmp;
+    if (!tmp.isValid()) {
+        qFatal("Cannot create temporary directory");
+    }
+
+    BenchStats lookup, setUnread, total;
+    {
+        AuxDatabase db(tmp.path(), tmp.path());
+        AvatarMapTable *table = db.getAvatarMapTable();
+        if (!table) {
+            qFatal("Cannot open database");
+        }
+
+        QVector<QPair<qint64, QString>> avatars;
+        for (int i = 0; i < chats; ++i) {
+            avatars.append(qMakePair(qint64(i) + 1, QString("/home/phablet/avatars/%1.jpg").arg(i + 1)));
+        }
+        table->setAvatarMapEntries(avatars);
+
+        for (int i = 0; i < iterations; ++i) {
+            QElapsedTimer timer;
+            timer.start();
+            table->getAvatarPathbyId(i % chats + 1);
+            lookup.add(timer.nsecsElapsed());
+
+            timer.restart();
+            table->setUnreadMapEntry(i % chats + 1, i % 9);
+            setUnread.add(timer.nsecsElapsed());
+
+            timer.restart();
+            table->getTotalUnread();
+            total.add(timer.nsecsElapsed());
+        }
+    }
+
+    // Every push is a new process, so startup is measured in children
+    BenchStats open, process;
+    for (int i = 0; i < qMin(iterations, 50); ++i) {
+        QProcess child;
+        child.start(QCoreApplication::applicationFilePath(), QStringList() << "--startup" << tmp.path());
+        if (!child.waitForFinished(10000) || child.exitCode() != 0) {
+            qFatal("Startup child failed");
+        }
+        QList<QByteArray> fields = child.readAllStandardOutput().trimmed().split(' ');
+        open.add(fields.value(0).toLongLong());
+        process.add(fields.value(1).toLongLong());
+    }
+
+    QTextStream(stdout) << "backend: " << AUXDB_BACKEND_NAME << "\n";
+    open.print("open + first lookup");
+    process.print("main() to first lookup");
+    lookup.print("getAvatarPathbyId");
+    setUnread.print("setUnreadMapEntry");
+    total.print("getTotalUnread");
+
+    return 0;
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * Per-push database time: the getAvatarPathbyId + setUnreadMapEntry +
+ * getTotalUnread sequence with per-call prepare() on a rollback-journal
+ * database (as before) against AuxDatabase's cached statements in WAL mode.
+ * Run it on the device's flash storage by pointing TMPDIR there.
+ *
+ * Usage: auxdb_sequence_bench [iterations]
+ */
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QVariant>
+#include <QLoggingCategory>
+
+#include "auxdatabase.h"
+#include "benchutil.h"
+
+static void legacySequence(QSqlDatabase &db, qint64 id, int unread)
+{
+    QSqlQuery select(db);
+    select.prepare("SELECT path FROM chatlist_map WHERE id = :id");
+    select.bindValue(":id", id);
+    select.exec();
+    select.next();
+
+    QSqlQuery update(db);
+    update.prepare("INSERT OR REPLACE INTO chatlist_map(id, path, unread_messages) "
+                   "VALUES(:id, COALESCE((SELECT path FROM chatlist_map WHERE id = :id), \"\"), :unread_messages)");
+    update.bindValue(":id", id);
+    update.bindValue(":unread_messages", unread);
+    update.exec();
+
+    QSqlQuery total(db);
+    total.prepare("SELECT COALESCE(SUM(unread_messages), 0) FROM chatlist_map");
+    total.exec();
+    total.next();
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    int iterations = argc > 1 ? QString(argv[1]).toInt() : 500;
+    const int chats = 200;
+
+    QLoggingCategory::setFilterRules("auxdb=false\navatarMapTable=false");
+
+    QTemporaryDir tmp;
+    BenchStats before, after;
+
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", "legacy");
+        db.setDatabaseName(tmp.filePath("legacy.sqlite"));
+        db.open();
+        QSqlQuery query(db);
+        query.exec("PRAGMA journal_mode = DELETE");
+        query.exec("PRAGMA synchronous = FULL");
+        query.exec("CREATE TABLE chatlist_map (id INTEGER NOT NULL UNIQUE, path TEXT NOT NULL, "
+                   "unread_messages INTEGER DEFAULT 0, PRIMARY KEY(id))");
+
+        for (int i = 0; i < iterations; ++i) {
+            QElapsedTimer timer;
+            timer.start();
+            legacySequence(db, i % chats + 1, i % 9);
+            before.add(timer.nsecsElapsed());
+        }
+        query.finish();
+        db.close();
+    }
+    QSqlDatabase::removeDatabase("legacy");
+
+    {
+        AuxDatabase db(tmp.filePath("auxdb"), tmp.path());
+        AvatarMapTable *table = db.getAvatarMapTable();
+
+        for (int i = 0; i < iterations; ++i) {
+            QElapsedTimer timer;
+            timer.start();
+            table->getAvatarPathbyId(i % chats + 1);
+            table->setUnreadMapEntry(i % chats + 1, i % 9);
+            table->getTotalUnread();
+            after.add(timer.nsecsElapsed());
+        }
+    }
+
+    before.print("prepare per call, DELETE");
+    after.print("cached statements, WAL");
+
+    return 0;
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * Badge total scaling: the old SUM over chatlist_map against the
+ * trigger-maintained unread_total row, at 1k, 100k and 1M chats.
+ *
+ * Usage: auxdb_unread_bench [iterations]
+ */
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QSqlQuery>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QLoggingCategory>
+
+#include "auxdatabase.h"
+#include "benchutil.h"
+
+static void populate(AuxDatabase &db, int chats)
+{
+    db.transaction();
+    QSqlQuery query(*db.getDB());
+    query.prepare("INSERT INTO chatlist_map(id, path, unread_messages) VALUES(:id, '', :unread)");
+    for (int i = 0; i < chats; ++i) {
+        query.bindValue(":id", qint64(i) + 1);
+        query.bindValue(":unread", i % 7);
+        query.exec();
+    }
+    db.commit();
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    int iterations = argc > 1 ? QString(argv[1]).toInt() : 200;
+
+    QLoggingCategory::setFilterRules("auxdb=false\navatarMapTable=false");
+
+    QTextStream out(stdout);
+    for (int chats : { 1000, 100000, 1000000 }) {
+        QTemporaryDir tmp;
+        BenchStats sum, counter, update;
+        {
+            AuxDatabase db(tmp.path(), tmp.path());
+            populate(db, chats);
+
+            QSqlQuery query(*db.getDB());
+            query.prepare("SELECT COALESCE(SUM(unread_messages), 0) FROM chatlist_map");
+            for (int i = 0; i < iterations; ++i) {
+                QElapsedTimer timer;
+                timer.start();
+                query.exec();
+                query.next();
+                sum.add(timer.nsecsElapsed());
+            }
+
+            for (int i = 0; i < iterations; ++i) {
+                QElapsedTimer timer;
+                timer.start();
+                db.getAvatarMapTable()->getTotalUnread();
+                counter.add(timer.nsecsElapsed());
+            }
+
+            for (int i = 0; i < iterations; ++i) {
+                QElapsedTimer timer;
+                timer.start();
+                db.getAvatarMapTable()->setUnreadMapEntry(i % chats + 1, i % 5);
+                db.getAvatarMapTable()->getTotalUnread();
+                update.add(timer.nsecsElapsed());
+            }
+
+            query.exec();
+            query.next();
+            if (query.value(0).toInt() != db.getAvatarMapTable()->getTotalUnread()) {
+                out << "MISMATCH between SUM and unread_total\n";
+            }
+            query.finish();
+        }
+        QSqlDatabase::removeDatabase("auxdb");
+
+        out << chats << " chats\n";
+        out.flush();
+        sum.print("  SUM(unread_messages)");
+        counter.print("  unread_total");
+        update.print("  set + total");
+    }
+
+    return 0;
+}
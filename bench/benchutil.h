@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * Small helpers shared by the push helper benchmarks
+ */
+
+#pragma once
+
+#include <QVector>
+#include <QString>
+#include <QTextStream>
+
+#include <algorithm>
+
+// Latency samples in nanoseconds and their summary
+struct BenchStats
+{
+    QVector<qint64> samples;
+
+    void add(qint64 ns) { samples.append(ns); }
+
+    qint64 percentile(double p) const
+    {
+        if (samples.isEmpty()) {
+            return 0;
+        }
+        QVector<qint64> sorted = samples;
+        std::sort(sorted.begin(), sorted.end());
+        int index = qBound(0, int(p * (sorted.size() - 1) + 0.5), sorted.size() - 1);
+        return sorted.at(index);
+    }
+
+    double mean() const
+    {
+        if (samples.isEmpty()) {
+            return 0;
+        }
+        double total = 0;
+        for (qint64 s : samples) {
+            total += s;
+        }
+        return total / samples.size();
+    }
+
+    void print(const QString &label) const
+    {
+        QTextStream out(stdout);
+        out.setFieldAlignment(QTextStream::AlignLeft);
+        out << qSetFieldWidth(28) << label << qSetFieldWidth(0)
+            << " n=" << samples.size()
+            << " mean=" << QString::number(mean() / 1000.0, 'f', 1) << "us"
+            << " p50=" << QString::number(percentile(0.50) / 1000.0, 'f', 1) << "us"
+            << " p95=" << QString::number(percentile(0.95) / 1000.0, 'f', 1) << "us"
+            << " p99=" << QString::number(percentile(0.99) / 1000.0, 'f', 1) << "us"
+            << "\n";
+    }
+};
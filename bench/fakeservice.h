@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * Stand-in for the Postal and Notifications services on a private bus
+ */
+
+#pragma once
+
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusVirtualObject>
+#include <QVariant>
+
+#include <atomic>
+
+// Answers every call on its path and below, counting them by member.
+// Virtual objects may be called from the D-Bus thread, hence the atomics.
+class FakeService : public QDBusVirtualObject
+{
+public:
+    std::atomic<int> notify{0};
+    std::atomic<int> post{0};
+    std::atomic<int> setCounter{0};
+    std::atomic<int> clearPersistent{0};
+    std::atomic<int> other{0};
+
+    void reset()
+    {
+        notify = post = setCounter = clearPersistent = other = 0;
+    }
+
+    QString introspect(const QString &) const override
+    {
+        return QString();
+    }
+
+    bool handleMessage(const QDBusMessage &message, const QDBusConnection &connection) override
+    {
+        const QString member = message.member();
+        if (member == "Notify") {
+            // Notify returns the id of the new notification
+            connection.send(message.createReply(QVariant::fromValue(uint(++notify))));
+            return true;
+        }
+
+        if (member == "Post") {
+            ++post;
+        } else if (member == "SetCounter") {
+            ++setCounter;
+        } else if (member == "ClearPersistent") {
+            ++clearPersistent;
+        } else {
+            ++other;
+        }
+        connection.send(message.createReply());
+        return true;
+    }
+};
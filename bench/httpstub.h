@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * Loopback stand-in for the push service's /notify endpoint
+ */
+
+#pragma once
+
+#include <QHostAddress>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QThread>
+
+#include <atomic>
+#include <memory>
+
+// Answers every POST with 200, or with 503 for every failEvery-th request
+// when set, honouring "Connection: close"
+class HttpStub : public QTcpServer
+{
+public:
+    std::atomic<int> failEvery{0};
+    std::atomic<int> requests{0};
+    std::atomic<qint64> bytes{0};
+
+    // Listens on a loopback port from thread, which must not be the
+    // caller's, so the stub does not compete with the sender for one
+    // event loop
+    bool start(QThread *thread)
+    {
+        moveToThread(thread);
+        thread->start();
+        bool listening = false;
+        QMetaObject::invokeMethod(this, [this, &listening]() {
+            listening = listen(QHostAddress::LocalHost, 0);
+        }, Qt::BlockingQueuedConnection);
+        return listening;
+    }
+
+    void stop(QThread *thread)
+    {
+        // Back to the caller's thread, which destroys it
+        QThread *caller = QThread::currentThread();
+        QMetaObject::invokeMethod(this, [this, caller]() {
+            close();
+            moveToThread(caller);
+        }, Qt::BlockingQueuedConnection);
+        thread->quit();
+        thread->wait();
+    }
+
+protected:
+    void incomingConnection(qintptr descriptor) override
+    {
+        auto *socket = new QTcpSocket(this);
+        socket->setSocketDescriptor(descriptor);
+        socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        auto input = std::make_shared<QByteArray>();
+
+        connect(socket, &QTcpSocket::readyRead, socket, [this, socket, input]() {
+            input->append(socket->readAll());
+
+            // Answer everything that is complete in one write
+            QByteArray output;
+            bool close = false;
+            while (!close) {
+                int end = input->indexOf("\r\n\r\n");
+                if (end < 0) {
+                    break;
+                }
+                QByteArray headers = input->left(end).toLower();
+                int length = 0;
+                int at = headers.indexOf("content-length:");
+                if (at >= 0) {
+                    length = headers.mid(at + 15, headers.indexOf("\r\n", at) - at - 15).trimmed().toInt();
+                }
+                if (input->size() < end + 4 + length) {
+                    break;
+                }
+                input->remove(0, end + 4 + length);
+                bytes += end + 4 + length;
+                close = headers.contains("connection: close");
+
+                int n = ++requests;
+                int every = failEvery;
+                bool fail = every > 0 && n % every == 0;
+                QByteArray body = fail ? "{\"error\":\"unavailable\"}" : "{}";
+                output += fail ? "HTTP/1.1 503 Service Unavailable\r\n" : "HTTP/1.1 200 OK\r\n";
+                output += "Content-Type: application/json\r\nContent-Length: " + QByteArray::number(body.size())
+                          + "\r\n" + (close ? "Connection: close\r\n" : "") + "\r\n" + body;
+            }
+            if (!output.isEmpty()) {
+                socket->write(output);
+            }
+            if (close) {
+                socket->disconnectFromHost();
+            }
+        });
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+    }
+};
@@ -0,0 +1,30 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * Values logged while handling one push, see log_sequence.h
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QLoggingCategory>
+#include <QString>
+#include <QStringList>
+
+struct LogSample
+{
+    QString locKey;
+    QStringList locArgs;
+    int badge;
+    qint64 chatId;
+    QString summary;
+    QString body;
+    QString icon;
+    QString tag;
+    QString outfile;
+    QString path;
+    QByteArray cardJson;
+};
+
+// The same statements compiled with QT_NO_DEBUG_OUTPUT, see push_log_stripped.cpp
+void logSequenceStripped(const QLoggingCategory &(*category)(), const LogSample &sample);
@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * The debug statements one push goes through, taken from PushHelper,
+ * AvatarMapTable, PostalClient and NotificationClient. Included once per
+ * variant with LOG_SEQUENCE naming the function and LOG_DEBUG the macro;
+ * deliberately without an include guard.
+ */
+
+#include <QByteArray>
+#include <QLoggingCategory>
+#include <QString>
+#include <QStringList>
+
+#include "log_sample.h"
+
+void LOG_SEQUENCE(const QLoggingCategory &(*category)(), const LogSample &sample)
+{
+    LOG_DEBUG(category) << "Starting push message processing";
+    LOG_DEBUG(category) << "Message type:" << sample.locKey;
+    LOG_DEBUG(category) << "Message arg count:" << sample.locArgs.size();
+    LOG_DEBUG(category) << "Badge count:" << sample.badge;
+    LOG_DEBUG(category) << "Extracted chat ID:" << sample.chatId;
+    LOG_DEBUG(category) << "Avatar path for chat" << sample.chatId << ":" << sample.icon;
+    LOG_DEBUG(category) << "Set unread count for chat" << sample.chatId << "to" << sample.badge;
+    LOG_DEBUG(category) << "Total unread count:" << sample.badge;
+    LOG_DEBUG(category) << "Wrote notification to output file:" << sample.outfile;
+    LOG_DEBUG(category) << "Notification JSON:" << sample.cardJson;
+    LOG_DEBUG(category) << "Sending notification popup:" << sample.summary << "-" << sample.body;
+    LOG_DEBUG(category) << "Sending notification:";
+    LOG_DEBUG(category) << "  Summary:" << sample.summary;
+    LOG_DEBUG(category) << "  Body:" << sample.body;
+    LOG_DEBUG(category) << "  Icon:" << sample.icon;
+    LOG_DEBUG(category) << "Posting persistent notification with tag:" << sample.tag;
+    LOG_DEBUG(category) << "Posting notification to Postal service";
+    LOG_DEBUG(category) << "D-Bus path:" << sample.path;
+    LOG_DEBUG(category) << "Message:" << QString::fromUtf8(sample.cardJson);
+    LOG_DEBUG(category) << "Setting badge count:" << sample.badge << "visible:" << true;
+    LOG_DEBUG(category) << "D-Bus path:" << sample.path;
+    LOG_DEBUG(category) << "Updated badge count to:" << sample.badge;
+    LOG_DEBUG(category) << "Push message processing completed";
+}
@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * Offline backlog replay. Fills a spool with queued push messages spread
+ * over a number of chats, some of them already expired, and drains it
+ * with push --batch on a private session bus with stand-ins for Postal and
+ * Notifications: once with backlog collapsing off, once with it on. The
+ * collapsed run must make exactly one Post per chat, one for the
+ * cross-chat summary, one Notify and one SetCounter.
+ *
+ * Usage: push_backlog_bench [messages] [chats]
+ */
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDBusConnection>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QProcess>
+#include <QSet>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QDebug>
+
+#include "fakeservice.h"
+#include "postal-client.h"
+#include "notification-client.h"
+
+// Every tenth round of messages expired before the device came back
+static bool isExpired(int round)
+{
+    return round % 10 == 9;
+}
+
+// Writes the backlog and returns the number of chats left with a live message
+static int writeSpool(const QDir &spool, int messages, int chats)
+{
+    QDateTime now = QDateTime::currentDateTimeUtc();
+    QString expired = now.addSecs(-3600).toString(Qt::ISODate);
+    QString live = now.addDays(1).toString(Qt::ISODate);
+
+    QSet<int> liveChats;
+    for (int i = 0; i < messages; ++i) {
+        int chat = i % chats;
+        int round = i / chats;
+        if (!isExpired(round)) {
+            liveChats.insert(chat);
+        }
+
+        // Queued over the last few hours, oldest first
+        qint64 sent = now.addSecs(-4 * 3600 + qint64(i) * 4 * 3600 / messages).toSecsSinceEpoch();
+
+        QFile file(spool.filePath(QString("%1.in").arg(i, 6, 10, QChar('0'))));
+        if (!file.open(QIODevice::WriteOnly)) {
+            qFatal("Cannot write spool file");
+        }
+        file.write(QString("{\"expire_on\":\"%1\",\"message\":{\"loc_key\":\"MESSAGE_TEXT\","
+                           "\"loc_args\":[\"Sender %2\",\"Queued message %3\"],"
+                           "\"badge\":%4,\"date\":%5,\"custom\":{\"from_id\":\"%6\"}}}")
+                       .arg(isExpired(round) ? expired : live).arg(chat).arg(i).arg(round + 1).arg(sent)
+                       .arg(100000 + chat)
+                       .toUtf8());
+    }
+    return liveChats.size();
+}
+
+// Drains a fresh spool in one push --batch run and returns its wall time,
+// waiting in an event loop so the stand-ins can answer the child
+static qint64 drain(const QTemporaryDir &tmp, const QString &name, int messages, int chats,
+                    const QString &backlogMin, int &liveChats)
+{
+    QDir spool(tmp.filePath(name));
+    spool.mkpath(".");
+    liveChats = writeSpool(spool, messages, chats);
+
+    // Each run gets its own database
+    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+    env.insert("XDG_DATA_HOME", tmp.filePath(name + "-data"));
+    env.insert("PUSH_HELPER_BACKLOG_MIN", backlogMin);
+
+    QProcess process;
+    process.setProcessEnvironment(env);
+    QEventLoop loop;
+    QObject::connect(&process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+                     &loop, &QEventLoop::quit);
+    QObject::connect(&process, &QProcess::errorOccurred, &loop, &QEventLoop::quit);
+
+    QElapsedTimer timer;
+    timer.start();
+    process.start(PUSH_EXECUTABLE, QStringList() << "--batch" << spool.path());
+    loop.exec();
+    qint64 elapsed = timer.nsecsElapsed();
+
+    if (process.exitStatus() != QProcess::NormalExit || process.exitCode() != 0) {
+        qFatal("push --batch failed");
+    }
+    return elapsed;
+}
+
+static void report(const QString &label, qint64 wallNs, FakeService &postal, FakeService &notifications)
+{
+    QTextStream out(stdout);
+    out.setFieldAlignment(QTextStream::AlignLeft);
+    out << qSetFieldWidth(28) << label << qSetFieldWidth(0)
+        << " wall=" << QString::number(wallNs / 1e6, 'f', 1) << "ms"
+        << " Notify " << notifications.notify.load()
+        << ", Post " << postal.post.load()
+        << ", SetCounter " << postal.setCounter.load()
+        << ", other " << postal.other.load() + notifications.other.load() << "\n";
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    int messages = argc > 1 ? QString(argv[1]).toInt() : 500;
+    int chats = argc > 2 ? QString(argv[2]).toInt() : 20;
+
+    QTemporaryDir tmp;
+    if (!tmp.isValid()) {
+        qFatal("Cannot create temporary directory");
+    }
+
+    // The child inherits the private bus address
+    QProcess bus;
+    bus.start("dbus-daemon", QStringList() << "--session" << "--nofork" << "--print-address");
+    if (!bus.waitForStarted() || !bus.waitForReadyRead(5000)) {
+        qFatal("Cannot start dbus-daemon");
+    }
+    QByteArray address = bus.readLine().trimmed();
+    qputenv("DBUS_SESSION_BUS_ADDRESS", address);
+    qputenv("PUSH_HELPER_SOCKET", tmp.filePath("push.sock").toUtf8());
+
+    FakeService postal;
+    FakeService notifications;
+    QDBusConnection services = QDBusConnection::connectToBus(QString::fromUtf8(address), "push_backlog_bench");
+    if (!services.registerService(POSTAL_SERVICE)
+            || !services.registerVirtualObject(POSTAL_PATH, &postal, QDBusConnection::SubPath)
+            || !services.registerService(NOTIFICATION_SERVICE)
+            || !services.registerVirtualObject(NOTIFICATION_PATH, &notifications, QDBusConnection::SubPath)) {
+        qFatal("Cannot register fake services: %s", qPrintable(services.lastError().message()));
+    }
+
+    QTextStream out(stdout);
+    out << "backlog: " << messages << " messages in " << chats << " chats\n";
+
+    int liveChats = 0;
+    qint64 wall = drain(tmp, "per-message", messages, chats, "0", liveChats);
+    report("collapsing off", wall, postal, notifications);
+    postal.reset();
+    notifications.reset();
+
+    wall = drain(tmp, "collapsed", messages, chats, "10", liveChats);
+    report("collapsed backlog", wall, postal, notifications);
+
+    int expectedPosts = liveChats > 1 ? liveChats + 1 : liveChats;
+    int expectedNotify = liveChats > 0 ? 1 : 0;
+    bool ok = postal.post == expectedPosts && notifications.notify == expectedNotify && postal.setCounter == 1
+              && postal.other == 0 && notifications.other == 0;
+    out << "expected Notify " << expectedNotify << ", Post " << expectedPosts << ", SetCounter 1\n";
+    out << (ok ? "PASS" : "FAIL") << "\n";
+
+    bus.terminate();
+    bus.waitForFinished(2000);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * Measures spool-directory batch throughput: fills a spool with push
+ * messages and drains it with a single push --batch run.
+ *
+ * Usage: push_batch_bench [messages]
+ */
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QProcess>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QDebug>
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    int messages = argc > 1 ? QString(argv[1]).toInt() : 1000;
+
+    QTemporaryDir tmp;
+    if (!tmp.isValid()) {
+        qFatal("Cannot create temporary directory");
+    }
+
+    QDir spool(tmp.filePath("spool"));
+    spool.mkpath(".");
+
+    // Spread the messages over a realistic number of chats
+    for (int i = 0; i < messages; ++i) {
+        QFile file(spool.filePath(QString("%1.in").arg(i, 6, 10, QChar('0'))));
+        if (!file.open(QIODevice::WriteOnly)) {
+            qFatal("Cannot write spool file");
+        }
+        file.write(QString("{\"message\":{\"loc_key\":\"MESSAGE_TEXT\","
+                           "\"loc_args\":[\"Sender %1\",\"Message number %2\"],"
+                           "\"badge\":%3,\"custom\":{\"from_id\":\"%4\"}}}")
+                       .arg(i % 50).arg(i).arg(i / 50 + 1).arg(100000 + i % 50)
+                       .toUtf8());
+    }
+
+    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+    env.insert("XDG_DATA_HOME", tmp.filePath("data"));
+
+    QProcess process;
+    process.setProcessEnvironment(env);
+
+    QElapsedTimer timer;
+    timer.start();
+    process.start(PUSH_EXECUTABLE, QStringList() << "--batch" << spool.path());
+    if (!process.waitForFinished(600000) || process.exitCode() != 0) {
+        qFatal("push --batch failed");
+    }
+    qint64 elapsed = timer.nsecsElapsed();
+
+    int written = spool.entryList(QStringList() << "*.out", QDir::Files).size();
+    int left = spool.entryList(QStringList() << "*.in", QDir::Files).size();
+
+    QTextStream out(stdout);
+    out << "messages: " << messages << " outfiles: " << written << " pending: " << left << "\n";
+    out << "wall time: " << QString::number(elapsed / 1e6, 'f', 1) << "ms\n";
+    out << "throughput: " << QString::number(messages / (elapsed / 1e9), 'f', 0) << " msg/s\n";
+
+    return 0;
+}
@@ -0,0 +1,228 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * End-to-end push helper benchmark. Starts a private session bus with
+ * stand-ins for the Postal and Notifications services, then runs a corpus
+ * covering every known loc_key through a cold push process per message
+ * and through one in-process PushHelper, against a temporary auxdb. Then
+ * checks burst coalescing: messages to a chat with a constant badge of 1
+ * or no badge pop up once, and a badge that drops starts a new burst.
+ *
+ * Usage: push_bench [messages]
+ */
+
+#include <QCoreApplication>
+#include <QDBusConnection>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QProcess>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QDebug>
+
+#include "benchutil.h"
+#include "fakeservice.h"
+#include "pushhelper.h"
+
+// One payload per loc_key in MessageFormatRegistry, plus one it does not know
+static const struct { const char *locKey; const char *args; } CORPUS[] = {
+    { "MESSAGE_TEXT", "[\"Alice\",\"Hey there! How are you?\"]" },
+    { "MESSAGE_PHOTO", "[\"Bob\"]" },
+    { "MESSAGE_VIDEO", "[\"Bob\"]" },
+    { "MESSAGE_AUDIO", "[\"Carol\"]" },
+    { "MESSAGE_VOICE_NOTE", "[\"Carol\"]" },
+    { "MESSAGE_STICKER", "[\"Dave\"]" },
+    { "MESSAGE_DOC", "[\"Dave\"]" },
+    { "MESSAGE_CONTACT", "[\"Erin\"]" },
+    { "MESSAGE_GEO", "[\"Erin\"]" },
+    { "MESSAGE_NOTEXT", "[\"Frank\"]" },
+    { "CHAT_MESSAGE_TEXT", "[\"Charlie\",\"My Friends\",\"Anyone up for coffee?\"]" },
+    { "CHAT_MESSAGE_PHOTO", "[\"Charlie\",\"My Friends\"]" },
+    { "CHAT_MESSAGE_VIDEO", "[\"Grace\",\"Hiking\"]" },
+    { "CHAT_CREATED", "[\"Grace\",\"Hiking\"]" },
+    { "CHAT_ADD_YOU", "[\"Heidi\",\"Book Club\"]" },
+    { "NEW_MESSAGE", "[]" },
+    { "MESSAGE_POLL", "[\"Ivan\"]" },
+};
+
+static QStringList writeCorpus(const QTemporaryDir &tmp)
+{
+    QStringList files;
+    const int count = int(sizeof(CORPUS) / sizeof(CORPUS[0]));
+    for (int i = 0; i < count; ++i) {
+        QString filename = tmp.filePath(QString("in_%1.json").arg(i));
+        QFile file(filename);
+        if (!file.open(QIODevice::WriteOnly)) {
+            qFatal("Cannot write payload");
+        }
+        file.write(QString("{\"message\":{\"loc_key\":\"%1\",\"loc_args\":%2,"
+                           "\"badge\":%3,\"custom\":{\"from_id\":\"%4\"}}}")
+                       .arg(CORPUS[i].locKey).arg(CORPUS[i].args).arg(i % 3 + 1).arg(100000 + i % 5)
+                       .toUtf8());
+        files.append(filename);
+    }
+    return files;
+}
+
+// Messages to one chat; a badge below 0 leaves it out of the payload
+static QStringList writeBurst(const QTemporaryDir &tmp, qint64 chat, const QVector<int> &badges)
+{
+    QStringList files;
+    for (int i = 0; i < badges.size(); ++i) {
+        QString filename = tmp.filePath(QString("burst_%1_%2.json").arg(chat).arg(i));
+        QFile file(filename);
+        if (!file.open(QIODevice::WriteOnly)) {
+            qFatal("Cannot write payload");
+        }
+        QString badge = badges.at(i) >= 0 ? QString("\"badge\":%1,").arg(badges.at(i)) : QString();
+        file.write(QString("{\"message\":{\"loc_key\":\"MESSAGE_TEXT\","
+                           "\"loc_args\":[\"Alice\",\"Burst message %1\"],%2"
+                           "\"custom\":{\"from_id\":\"%3\"}}}")
+                       .arg(i).arg(badge).arg(chat)
+                       .toUtf8());
+        files.append(filename);
+    }
+    return files;
+}
+
+static void report(const QString &label, const BenchStats &stats, qint64 wallNs, FakeService &postal,
+                   FakeService &notifications)
+{
+    QTextStream out(stdout);
+    stats.print(label);
+    out << "  throughput: " << QString::number(stats.samples.size() / (wallNs / 1e9), 'f', 1) << " msg/s"
+        << ", Notify " << notifications.notify.load()
+        << ", Post " << postal.post.load()
+        << ", SetCounter " << postal.setCounter.load()
+        << ", ClearPersistent " << postal.clearPersistent.load()
+        << ", other " << postal.other.load() + notifications.other.load() << "\n";
+    postal.reset();
+    notifications.reset();
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    int messages = argc > 1 ? QString(argv[1]).toInt() : 200;
+
+    QTemporaryDir tmp;
+    if (!tmp.isValid()) {
+        qFatal("Cannot create temporary directory");
+    }
+
+    // A private bus keeps the stand-ins away from the real services; it
+    // has to be in the environment before anything touches the session bus
+    QProcess bus;
+    bus.start("dbus-daemon", QStringList() << "--session" << "--nofork" << "--print-address");
+    if (!bus.waitForStarted() || !bus.waitForReadyRead(5000)) {
+        qFatal("Cannot start dbus-daemon");
+    }
+    QByteArray address = bus.readLine().trimmed();
+    qputenv("DBUS_SESSION_BUS_ADDRESS", address);
+
+    // Keep the benchmark away from the real database and any running daemon
+    qputenv("XDG_DATA_HOME", tmp.filePath("data").toUtf8());
+    qputenv("PUSH_HELPER_SOCKET", tmp.filePath("push.sock").toUtf8());
+    QCoreApplication::setApplicationName(QStringLiteral("pushnotification.surajyadav"));
+    QCoreApplication::setOrganizationName(QStringLiteral("pushnotification.surajyadav"));
+
+    // The stand-ins get their own connection, so in-process calls make a
+    // real round trip through the bus daemon
+    FakeService postal;
+    FakeService notifications;
+    QDBusConnection services = QDBusConnection::connectToBus(QString::fromUtf8(address), "push_bench_services");
+    if (!services.registerService(POSTAL_SERVICE)
+            || !services.registerVirtualObject(POSTAL_PATH, &postal, QDBusConnection::SubPath)
+            || !services.registerService(NOTIFICATION_SERVICE)
+            || !services.registerVirtualObject(NOTIFICATION_PATH, &notifications, QDBusConnection::SubPath)) {
+        qFatal("Cannot register fake services: %s", qPrintable(services.lastError().message()));
+    }
+
+    QStringList corpus = writeCorpus(tmp);
+    QString outfile = tmp.filePath("out.json");
+
+    // Cold: one push process per message, as the push service runs it.
+    // Wait in an event loop so the stand-ins can answer the child.
+    BenchStats cold;
+    QElapsedTimer wall;
+    wall.start();
+    for (int i = 0; i < messages; ++i) {
+        QProcess process;
+        QEventLoop loop;
+        QObject::connect(&process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+                         &loop, &QEventLoop::quit);
+        QObject::connect(&process, &QProcess::errorOccurred, &loop, &QEventLoop::quit);
+
+        QElapsedTimer timer;
+        timer.start();
+        process.start(PUSH_EXECUTABLE, QStringList() << corpus.at(i % corpus.size()) << outfile);
+        loop.exec();
+        cold.add(timer.nsecsElapsed());
+
+        if (process.exitStatus() != QProcess::NormalExit || process.exitCode() != 0) {
+            qWarning() << "Cold run failed for" << corpus.at(i % corpus.size());
+        }
+    }
+    report("cold process", cold, wall.nsecsElapsed(), postal, notifications);
+
+    // In-process: one PushHelper for every message, like the daemon
+    PushHelper helper("pushnotification.surajyadav_pushnotification", QString(), QString());
+    bool finished = false;
+    QEventLoop loop;
+    QObject::connect(&helper, &PushHelper::done, &loop, [&]() {
+        finished = true;
+        loop.quit();
+    });
+
+    // Open the database and connect to the bus outside the measurement
+    helper.process(corpus.first(), outfile);
+    if (!finished) {
+        loop.exec();
+    }
+    postal.reset();
+    notifications.reset();
+
+    BenchStats warm;
+    wall.restart();
+    for (int i = 0; i < messages; ++i) {
+        finished = false;
+        QElapsedTimer timer;
+        timer.start();
+        helper.process(corpus.at(i % corpus.size()), outfile);
+        if (!finished) {
+            loop.exec();
+        }
+        warm.add(timer.nsecsElapsed());
+    }
+    report("in-process", warm, wall.nsecsElapsed(), postal, notifications);
+
+    // Every message is posted; only those that start a burst pop up
+    const struct { const char *label; qint64 chat; QVector<int> badges; int notify; } bursts[] = {
+        { "burst, badge always 1", 900001, { 1, 1, 1, 1 }, 1 },
+        { "burst, no badge", 900002, { -1, -1, -1 }, 1 },
+        { "burst, read in between", 900003, { 2, 3, 1, 2 }, 2 },
+    };
+    QTextStream out(stdout);
+    bool ok = true;
+    for (const auto &burst : bursts) {
+        postal.reset();
+        notifications.reset();
+        for (const QString &infile : writeBurst(tmp, burst.chat, burst.badges)) {
+            finished = false;
+            helper.process(infile, outfile);
+            if (!finished) {
+                loop.exec();
+            }
+        }
+        bool passed = notifications.notify == burst.notify && postal.post == burst.badges.size();
+        out << burst.label << ": Notify " << notifications.notify.load() << " (expected " << burst.notify
+            << "), Post " << postal.post.load() << " (expected " << burst.badges.size() << ")\n";
+        ok = ok && passed;
+    }
+    out << (ok ? "PASS" : "FAIL") << "\n";
+
+    bus.terminate();
+    bus.waitForFinished(2000);
+    return ok ? 0 : 1;
+}
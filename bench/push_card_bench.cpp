@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * Compares building the notification JSON the old way (a QJsonObject tree
+ * per consumer, once for the outfile and once for Postal) against a single
+ * NotificationCard::serialize() into a reused buffer. Fails unless both
+ * produce the same document and NotificationCard allocates at most half as
+ * often per push as the old way, and no more than MAX_CARD_ALLOCATIONS.
+ *
+ * Usage: push_card_bench [iterations]
+ */
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "notification-card.h"
+
+static std::atomic<qint64> allocations(0);
+
+// The reused buffer is only regrown when a card outgrows it
+static const double MAX_CARD_ALLOCATIONS = 1.0;
+
+void *operator new(size_t size)
+{
+    ++allocations;
+    if (void *p = malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    free(p);
+}
+
+// Roughly what writeOutputFile() and PostalClient::postNotification() did,
+// each building its own tree from the same fields
+static QByteArray buildWithJsonObject(const NotificationCard &source)
+{
+    QJsonObject card;
+    card["summary"] = source.summary;
+    card["body"] = source.body;
+    card["icon"] = source.icon;
+    card["persist"] = source.persist;
+    card["popup"] = source.popup;
+    if (!source.actions.isEmpty()) {
+        card["actions"] = QJsonArray::fromStringList(source.actions);
+    }
+
+    QJsonObject notification;
+    notification["card"] = card;
+    notification["tag"] = source.tag;
+    notification["vibrate"] = source.vibrate;
+    notification["sound"] = source.sound;
+    if (source.emblemCount > 0) {
+        QJsonObject emblem;
+        emblem["count"] = source.emblemCount;
+        emblem["visible"] = true;
+        notification["emblem-counter"] = emblem;
+    }
+
+    QJsonObject root;
+    root["notification"] = notification;
+    return QJsonDocument(root).toJson(QJsonDocument::Compact);
+}
+
+// Returns the allocations per push
+template <typename Build>
+static double run(const QString &label, int iterations, Build build)
+{
+    // Warm up caches and any lazily created Qt state
+    for (int i = 0; i < 100; ++i) {
+        build();
+    }
+
+    qint64 checksum = 0;
+    qint64 allocationsBefore = allocations;
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        checksum += build();
+    }
+    qint64 elapsed = timer.nsecsElapsed();
+    qint64 allocated = allocations - allocationsBefore;
+
+    QTextStream out(stdout);
+    out << label << ": " << QString::number(double(elapsed) / iterations, 'f', 0) << " ns/push, "
+        << QString::number(double(allocated) / iterations, 'f', 1) << " allocations/push"
+        << " (checksum " << checksum << ")\n";
+    return double(allocated) / iterations;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    int iterations = argc > 1 ? QString(argv[1]).toInt() : 100000;
+
+    NotificationCard card;
+    card.summary = "Charlie";
+    card.body = QString::fromUtf8("Charlie: Anyone up for \"coffee\"? \xe2\x98\x95\n\xf0\x9f\x98\x80");
+    card.icon = "/home/phablet/.local/share/pushnotification/avatars/345678.jpg";
+    card.tag = "chat_345678";
+    card.actions << "pushnotification://chat/345678";
+    card.emblemCount = 7;
+
+    QTextStream out(stdout);
+
+    // Same document either way, field order aside
+    QByteArray streamed;
+    card.serialize(streamed);
+    QJsonParseError error;
+    QJsonDocument parsed = QJsonDocument::fromJson(streamed, &error);
+    bool same = error.error == QJsonParseError::NoError
+        && parsed == QJsonDocument::fromJson(buildWithJsonObject(card));
+    out << "serialized output: " << (same ? "OK" : "MISMATCH") << "\n";
+    if (!same) {
+        out << streamed << "\n" << buildWithJsonObject(card) << "\n";
+        return 1;
+    }
+
+    double before = run("QJsonObject x2", iterations, [&]() {
+        return buildWithJsonObject(card).size() + buildWithJsonObject(card).size();
+    });
+
+    QByteArray buffer;
+    double after = run("NotificationCard", iterations, [&]() {
+        card.serialize(buffer);
+        return buffer.size();
+    });
+
+    bool ok = after * 2 <= before && after <= MAX_CARD_ALLOCATIONS;
+    out << "expected at most " << QString::number(qMin(before / 2, MAX_CARD_ALLOCATIONS), 'f', 1)
+        << " allocations/push\n";
+    out << (ok ? "PASS" : "FAIL") << "\n";
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,176 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * Compares the JSON payload against the compact CBOR one, raw and
+ * base64-wrapped in JSON as it travels through the push service, over one
+ * payload per known loc_key. Reports total payload bytes and PushMessage
+ * decode time, and fails unless every form decodes to the same message.
+ *
+ * Usage: push_cbor_bench [iterations]
+ */
+
+#include <QCoreApplication>
+#include <QCborStreamWriter>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QTextStream>
+#include <QVector>
+
+#include <cstring>
+
+#include "pushmessage.h"
+
+// One payload per loc_key in MessageFormatRegistry, plus one it does not know
+static const struct { const char *locKey; QVector<const char *> args; } CORPUS[] = {
+    { "MESSAGE_TEXT", { "Alice", "Hey there! How are you?" } },
+    { "MESSAGE_PHOTO", { "Bob" } },
+    { "MESSAGE_VIDEO", { "Bob" } },
+    { "MESSAGE_AUDIO", { "Carol" } },
+    { "MESSAGE_VOICE_NOTE", { "Carol" } },
+    { "MESSAGE_STICKER", { "Dave" } },
+    { "MESSAGE_DOC", { "Dave" } },
+    { "MESSAGE_CONTACT", { "Erin" } },
+    { "MESSAGE_GEO", { "Erin" } },
+    { "MESSAGE_NOTEXT", { "Frank" } },
+    { "CHAT_MESSAGE_TEXT", { "Charlie", "My Friends", "Anyone up for coffee?" } },
+    { "CHAT_MESSAGE_PHOTO", { "Charlie", "My Friends" } },
+    { "CHAT_MESSAGE_VIDEO", { "Grace", "Hiking" } },
+    { "CHAT_CREATED", { "Grace", "Hiking" } },
+    { "CHAT_ADD_YOU", { "Heidi", "Book Club" } },
+    { "NEW_MESSAGE", {} },
+    { "MESSAGE_POLL", { "Ivan" } },
+};
+
+struct Payloads
+{
+    QByteArray json;
+    QByteArray cbor;
+    QByteArray wrapped;
+};
+
+static Payloads encode(int index, qint64 sent, qint64 expires)
+{
+    const auto &entry = CORPUS[index];
+    bool group = QByteArray(entry.locKey).startsWith("CHAT_");
+    qint64 chatId = 100000 + index;
+    int badge = index % 3 + 1;
+
+    // What server-example.py sends
+    QByteArray args;
+    for (const char *arg : entry.args) {
+        args += (args.isEmpty() ? "\"" : ",\"") + QByteArray(arg) + "\"";
+    }
+    Payloads payloads;
+    payloads.json = QString("{\"expire_on\":\"%1\",\"message\":{\"loc_key\":\"%2\",\"loc_args\":[%3],"
+                            "\"badge\":%4,\"date\":%5,\"custom\":{\"%6\":\"%7\"}}}")
+                        .arg(QDateTime::fromSecsSinceEpoch(expires, Qt::UTC).toString(Qt::ISODate))
+                        .arg(entry.locKey).arg(QString::fromUtf8(args)).arg(badge).arg(sent)
+                        .arg(group ? "chat_id" : "from_id").arg(chatId)
+                        .toUtf8();
+
+    QCborStreamWriter writer(&payloads.cbor);
+    writer.startMap(2);
+    writer.append(quint64(PushCbor::ExpireOn));
+    writer.append(expires);
+    writer.append(quint64(PushCbor::Message));
+    writer.startMap(5);
+    writer.append(quint64(PushCbor::LocKey));
+    writer.appendTextString(entry.locKey, qsizetype(strlen(entry.locKey)));
+    writer.append(quint64(PushCbor::LocArgs));
+    writer.startArray(quint64(entry.args.size()));
+    for (const char *arg : entry.args) {
+        writer.appendTextString(arg, qsizetype(strlen(arg)));
+    }
+    writer.endArray();
+    writer.append(quint64(PushCbor::Badge));
+    writer.append(qint64(badge));
+    writer.append(quint64(PushCbor::Date));
+    writer.append(sent);
+    writer.append(quint64(PushCbor::Custom));
+    writer.startMap(1);
+    writer.append(quint64(group ? PushCbor::ChatId : PushCbor::FromId));
+    writer.append(chatId);
+    writer.endMap();
+    writer.endMap();
+    writer.endMap();
+
+    payloads.wrapped = "{\"cbor\":\"" + payloads.cbor.toBase64() + "\"}";
+    return payloads;
+}
+
+// Everything the helper reads from a message, for comparing the forms
+static QString summarize(const QByteArray &payload)
+{
+    PushMessage message;
+    if (!message.decode(payload)) {
+        return QString();
+    }
+    QStringList fields;
+    fields << PushMessage::toString(message.locKey) << QString::number(message.badge)
+           << QString::number(PushMessage::toLongLong(message.fromId))
+           << QString::number(PushMessage::toLongLong(message.chatId))
+           << QString::number(message.sentAtMs()) << QString::number(message.expiresAtMs());
+    for (int i = 0; i < message.locArgCount; ++i) {
+        fields << message.locArg(i);
+    }
+    return fields.join('|');
+}
+
+static void run(const QString &label, const QVector<QByteArray> &payloads, int iterations)
+{
+    qint64 bytes = 0;
+    for (const QByteArray &payload : payloads) {
+        bytes += payload.size();
+    }
+
+    PushMessage message;
+    qint64 checksum = 0;
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        message.decode(payloads.at(i % payloads.size()));
+        checksum += message.badge + message.locArgCount;
+    }
+    qint64 elapsed = timer.nsecsElapsed();
+
+    QTextStream out(stdout);
+    out.setFieldAlignment(QTextStream::AlignLeft);
+    out << qSetFieldWidth(14) << label << qSetFieldWidth(0)
+        << " " << bytes << " bytes (" << QString::number(double(bytes) / payloads.size(), 'f', 1) << "/payload), "
+        << QString::number(double(elapsed) / iterations, 'f', 0) << " ns/decode"
+        << " (checksum " << checksum << ")\n";
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    int iterations = argc > 1 ? QString(argv[1]).toInt() : 200000;
+
+    qint64 now = QDateTime::currentSecsSinceEpoch();
+    QVector<QByteArray> json;
+    QVector<QByteArray> cbor;
+    QVector<QByteArray> wrapped;
+    int mismatches = 0;
+    const int count = int(sizeof(CORPUS) / sizeof(CORPUS[0]));
+    for (int i = 0; i < count; ++i) {
+        Payloads payloads = encode(i, now - i, now + 86400);
+        json.append(payloads.json);
+        cbor.append(payloads.cbor);
+        wrapped.append(payloads.wrapped);
+
+        QString expected = summarize(payloads.json);
+        if (expected.isEmpty() || summarize(payloads.cbor) != expected || summarize(payloads.wrapped) != expected) {
+            qWarning("Payload forms disagree for %s", CORPUS[i].locKey);
+            ++mismatches;
+        }
+    }
+
+    run("JSON", json, iterations);
+    run("CBOR", cbor, iterations);
+    run("CBOR in JSON", wrapped, iterations);
+
+    QTextStream out(stdout);
+    out << (mismatches == 0 ? "PASS" : "FAIL") << "\n";
+    return mismatches == 0 ? 0 : 1;
+}
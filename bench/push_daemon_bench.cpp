@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * Compares per-message latency of a cold push helper process against
+ * the resident push daemon, both through the push shim and directly
+ * over the daemon socket.
+ *
+ * Usage: push_daemon_bench [iterations]
+ */
+
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QLocalSocket>
+#include <QProcess>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QDebug>
+
+#include "benchutil.h"
+
+static const char *PAYLOAD =
+    "{\"message\":{\"loc_key\":\"MESSAGE_TEXT\","
+    "\"loc_args\":[\"Alice\",\"Hey there! How are you?\"],"
+    "\"badge\":1,\"custom\":{\"from_id\":\"123456\"}}}";
+
+static bool runShim(const QProcessEnvironment &env, const QString &infile, const QString &outfile)
+{
+    QProcess process;
+    process.setProcessEnvironment(env);
+    process.start(PUSH_EXECUTABLE, QStringList() << infile << outfile);
+    return process.waitForFinished(10000) && process.exitCode() == 0;
+}
+
+static bool sendJob(const QString &socketName, const QString &infile, const QString &outfile)
+{
+    QLocalSocket socket;
+    socket.connectToServer(socketName);
+    if (!socket.waitForConnected(1000)) {
+        return false;
+    }
+
+    QDataStream stream(&socket);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << infile << outfile;
+    socket.waitForBytesWritten(1000);
+
+    bool ok = false;
+    while (true) {
+        stream.startTransaction();
+        stream >> ok;
+        if (stream.commitTransaction()) {
+            return ok;
+        }
+        if (!socket.waitForReadyRead(5000)) {
+            return false;
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    int iterations = argc > 1 ? QString(argv[1]).toInt() : 20;
+
+    QTemporaryDir tmp;
+    if (!tmp.isValid()) {
+        qFatal("Cannot create temporary directory");
+    }
+
+    QString infile = tmp.filePath("in.json");
+    QString outfile = tmp.filePath("out.json");
+    QString socketName = tmp.filePath("push.sock");
+
+    QFile in(infile);
+    if (!in.open(QIODevice::WriteOnly)) {
+        qFatal("Cannot write payload");
+    }
+    in.write(PAYLOAD);
+    in.close();
+
+    // Keep the benchmark away from the real database and any running daemon
+    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+    env.insert("XDG_DATA_HOME", tmp.filePath("data"));
+    env.insert("PUSH_HELPER_SOCKET", socketName);
+
+    BenchStats cold;
+    for (int i = 0; i < iterations; ++i) {
+        QElapsedTimer timer;
+        timer.start();
+        if (!runShim(env, infile, outfile)) {
+            qWarning() << "Cold run failed";
+        }
+        cold.add(timer.nsecsElapsed());
+    }
+
+    QProcess daemon;
+    daemon.setProcessEnvironment(env);
+    daemon.start(PUSH_EXECUTABLE, QStringList() << "--daemon");
+    if (!daemon.waitForStarted()) {
+        qFatal("Cannot start push daemon");
+    }
+
+    // Wait for the daemon to start listening and warm it up once
+    bool ready = false;
+    for (int i = 0; i < 100 && !ready; ++i) {
+        ready = sendJob(socketName, infile, outfile);
+        if (!ready) {
+            QThread::msleep(50);
+        }
+    }
+    if (!ready) {
+        daemon.kill();
+        qFatal("Push daemon did not come up");
+    }
+
+    BenchStats warmShim;
+    for (int i = 0; i < iterations; ++i) {
+        QElapsedTimer timer;
+        timer.start();
+        if (!runShim(env, infile, outfile)) {
+            qWarning() << "Warm shim run failed";
+        }
+        warmShim.add(timer.nsecsElapsed());
+    }
+
+    BenchStats warmSocket;
+    for (int i = 0; i < iterations; ++i) {
+        QElapsedTimer timer;
+        timer.start();
+        if (!sendJob(socketName, infile, outfile)) {
+            qWarning() << "Warm socket job failed";
+        }
+        warmSocket.add(timer.nsecsElapsed());
+    }
+
+    daemon.terminate();
+    if (!daemon.waitForFinished(2000)) {
+        daemon.kill();
+        daemon.waitForFinished();
+    }
+
+    cold.print("cold process");
+    warmShim.print("warm daemon via shim");
+    warmSocket.print("warm daemon via socket");
+
+    return 0;
+}
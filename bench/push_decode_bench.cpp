@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * Compares the old readPushMessage() path (QString round-trip, full
+ * QJsonDocument DOM, string-keyed lookups) against PushMessage.
+ * Reports nanoseconds and heap allocations per decode.
+ *
+ * Usage: push_decode_bench [iterations]
+ */
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLoggingCategory>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QDebug>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "pushmessage.h"
+
+Q_LOGGING_CATEGORY(benchHelper, "benchHelper", QtWarningMsg)
+
+static std::atomic<qint64> allocations(0);
+
+void *operator new(size_t size)
+{
+    ++allocations;
+    if (void *p = malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    free(p);
+}
+
+static const char *PAYLOAD =
+    "{\"message\":{\"loc_key\":\"CHAT_MESSAGE_TEXT\","
+    "\"loc_args\":[\"Charlie\",\"My Friends\",\"Anyone up for coffee? \\u2615\"],"
+    "\"badge\":3,\"custom\":{\"chat_id\":\"345678\",\"msg_id\":\"9912\"}},"
+    "\"appid\":\"pushnotification.surajyadav_pushnotification\"}";
+
+// What PushHelper did before PushMessage existed
+static int decodeWithJsonDocument(const QString &filename)
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return -1;
+    }
+    QString val = file.readAll();
+    file.close();
+
+    QJsonParseError parseError;
+    QJsonDocument doc = QJsonDocument::fromJson(val.toUtf8(), &parseError);
+    if (parseError.error != QJsonParseError::NoError) {
+        return -1;
+    }
+    qDebug(benchHelper) << "Successfully read push message:" << doc.object();
+
+    QJsonObject pushMessage = doc.object();
+    QJsonObject message = pushMessage["message"].toObject();
+    QString locKey = message["loc_key"].toString();
+    QJsonArray locArgs = message["loc_args"].toArray();
+    QJsonObject custom = message["custom"].toObject();
+    int badge = message["badge"].toInt();
+    qint64 chatId = custom["chat_id"].toString().toLongLong();
+    QString sender = locArgs[0].toString();
+
+    return badge + int(chatId & 1) + locKey.size() + sender.size();
+}
+
+static int decodeWithPushMessage(const QString &filename)
+{
+    PushMessage message;
+    if (!message.readFile(filename)) {
+        return -1;
+    }
+    qint64 chatId = PushMessage::toLongLong(message.chatId);
+
+    return message.badge + int(chatId & 1) + int(message.locKey.size()) + int(message.locArgs[0].size());
+}
+
+template <typename Decode>
+static void run(const QString &label, const QString &filename, int iterations, Decode decode)
+{
+    // Warm up caches and any lazily created Qt state
+    for (int i = 0; i < 100; ++i) {
+        decode(filename);
+    }
+
+    qint64 checksum = 0;
+    qint64 allocationsBefore = allocations;
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        checksum += decode(filename);
+    }
+    qint64 elapsed = timer.nsecsElapsed();
+    qint64 allocated = allocations - allocationsBefore;
+
+    QTextStream out(stdout);
+    out << label << ": " << QString::number(double(elapsed) / iterations, 'f', 0) << " ns/decode, "
+        << QString::number(double(allocated) / iterations, 'f', 1) << " allocations/decode"
+        << " (checksum " << checksum << ")\n";
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    int iterations = argc > 1 ? QString(argv[1]).toInt() : 100000;
+
+    QTemporaryDir tmp;
+    QString filename = tmp.filePath("in.json");
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qFatal("Cannot write payload");
+    }
+    file.write(PAYLOAD);
+    file.close();
+
+    run("QJsonDocument", filename, iterations, decodeWithJsonDocument);
+    run("PushMessage", filename, iterations, decodeWithPushMessage);
+
+    return 0;
+}
@@ -0,0 +1,192 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * One group message to many devices. Compares serializing the whole
+ * envelope per recipient, as server-example.py does, against serializing
+ * it once and splicing in each device's token and replace_tag: sender
+ * thread CPU per recipient and bytes built per recipient, for building the
+ * requests alone and for sending them to a loopback HTTP stub of the push
+ * service. Fails unless the spliced bodies carry the same JSON and every
+ * request is delivered.
+ *
+ * Usage: push_fanout_bench [recipients]
+ */
+
+#include <QCoreApplication>
+#include <QEventLoop>
+#include <QJsonDocument>
+#include <QTextStream>
+#include <QThread>
+
+#include <ctime>
+
+#include "httpstub.h"
+#include "pushsender.h"
+
+static const char APP_ID[] = "pushnotification.surajyadav_pushnotification";
+static const char REPLACE_TAG[] = "msg_345678";
+
+// CPU time of the calling thread; the stub runs on its own
+static qint64 threadCpuNs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return qint64(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+static QVector<QByteArray> makeTokens(int count)
+{
+    QVector<QByteArray> tokens;
+    tokens.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        // Roughly the shape and length of real push service tokens
+        tokens.append("cHVzaC10b2tlbi1kZXZpY2Ut" + QByteArray::number(1000000 + i) + "LXVidXBvcnRzLWxvbWlyaQ==");
+    }
+    return tokens;
+}
+
+// The spliced body must parse to what a per-recipient QJsonObject gives,
+// including for tokens and tags that need escaping
+static bool verify(const QJsonObject &data, const QDateTime &expires)
+{
+    PushEnvelope envelope(APP_ID, data, true, expires);
+    const QByteArray samples[][2] = {
+        { "cHVzaC10b2tlbi1kZXZpY2UtMTAwMDAwMA==", REPLACE_TAG },
+        { "odd\"token\\with\ncontrols", "tag \"quoted\" \xc3\xa9" },
+        { "no-tag", "" },
+    };
+
+    for (const auto &sample : samples) {
+        PushRequest request;
+        request.token = sample[0];
+        request.data = data;
+        request.replaceTag = QString::fromUtf8(sample[1]);
+        request.expireOn = expires;
+
+        QString expireText = expires.toUTC().toString(Qt::ISODateWithMs);
+        QJsonObject payload = data;
+        payload.insert("expire_on", expireText);
+        QJsonObject expected;
+        expected.insert("appid", APP_ID);
+        expected.insert("expire_on", expireText);
+        expected.insert("token", QString::fromUtf8(request.token));
+        expected.insert("clear_pending", true);
+        expected.insert("replace_tag", request.replaceTag.isEmpty() ? QJsonValue() : QJsonValue(request.replaceTag));
+        expected.insert("data", payload);
+
+        QByteArray body = envelope.body(sample[0], sample[1]);
+        QJsonParseError error;
+        QJsonDocument parsed = QJsonDocument::fromJson(body, &error);
+        if (error.error != QJsonParseError::NoError || parsed.object() != expected
+                || envelope.tailSize(sample[0], sample[1]) != body.size() - envelope.shared().size()) {
+            qWarning("Spliced body differs for %s: %s", sample[0].constData(), body.constData());
+            return false;
+        }
+    }
+    return true;
+}
+
+static void report(const QString &label, qint64 cpuNs, const QString &detail)
+{
+    QTextStream out(stdout);
+    out.setFieldAlignment(QTextStream::AlignLeft);
+    out << qSetFieldWidth(34) << label << qSetFieldWidth(0)
+        << " " << QString::number(double(cpuNs), 'f', 0) << " ns CPU/recipient, " << detail << "\n";
+}
+
+// Builds every request without sending it
+static void build(const QJsonObject &data, const QVector<QByteArray> &tokens, bool once)
+{
+    QByteArray head = "POST /notify HTTP/1.1\r\nHost: 127.0.0.1\r\nContent-Type: application/json\r\n"
+                      "Content-Length: ";
+    qint64 bytes = 0;
+    qint64 start = threadCpuNs();
+    if (once) {
+        PushEnvelope envelope(APP_ID, data);
+        for (const QByteArray &token : tokens) {
+            int tail = envelope.tailSize(token, REPLACE_TAG);
+            QByteArray own;
+            own.reserve(head.size() + 16 + tail);
+            own += head;
+            own += QByteArray::number(envelope.shared().size() + tail);
+            own += "\r\n\r\n";
+            envelope.appendTail(own, token, REPLACE_TAG);
+            bytes += own.size();
+        }
+    } else {
+        for (const QByteArray &token : tokens) {
+            PushRequest request;
+            request.token = token;
+            request.data = data;
+            request.replaceTag = REPLACE_TAG;
+            QByteArray body = request.envelope(APP_ID);
+            QByteArray own = head + QByteArray::number(body.size()) + "\r\n\r\n" + body;
+            bytes += own.size();
+        }
+    }
+    qint64 cpu = threadCpuNs() - start;
+    report(once ? "build, serialize once" : "build, serialize per recipient", cpu / tokens.size(),
+           QString("%1 bytes built/recipient").arg(bytes / tokens.size()));
+}
+
+static bool send(HttpStub &server, const QJsonObject &data, const QVector<QByteArray> &tokens, bool once)
+{
+    server.requests = 0;
+    server.bytes = 0;
+
+    PushSender sender(QUrl(QString("http://127.0.0.1:%1/notify").arg(server.serverPort())), APP_ID);
+    QEventLoop loop;
+    QObject::connect(&sender, &PushSender::idle, &loop, &QEventLoop::quit);
+
+    qint64 start = threadCpuNs();
+    if (once) {
+        PushEnvelope envelope(APP_ID, data);
+        for (const QByteArray &token : tokens) {
+            sender.send(envelope, token, REPLACE_TAG);
+        }
+    } else {
+        for (const QByteArray &token : tokens) {
+            PushRequest request;
+            request.token = token;
+            request.data = data;
+            request.replaceTag = REPLACE_TAG;
+            sender.send(request);
+        }
+    }
+    loop.exec();
+    qint64 cpu = threadCpuNs() - start;
+
+    PushSenderStats stats = sender.stats();
+    report(once ? "send, serialize once" : "send, serialize per recipient", cpu / tokens.size(),
+           QString("%1 bytes sent/recipient, delivered %2/%3")
+               .arg(server.bytes.load() / tokens.size()).arg(stats.delivered).arg(tokens.size()));
+    return stats.delivered == tokens.size() && stats.failed == 0;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    int recipients = argc > 1 ? QString(argv[1]).toInt() : 10000;
+
+    QJsonObject data = PushPayload::groupMessage("Charlie", "My Friends", "Anyone up for coffee?", 345678, 3);
+    QVector<QByteArray> tokens = makeTokens(recipients);
+
+    QTextStream out(stdout);
+    out << "fan-out to " << recipients << " recipients\n";
+    bool ok = verify(data, QDateTime::currentDateTimeUtc().addDays(1));
+
+    build(data, tokens, false);
+    build(data, tokens, true);
+
+    QThread thread;
+    HttpStub server;
+    if (!server.start(&thread)) {
+        qFatal("Cannot listen on loopback");
+    }
+    ok = send(server, data, tokens, false) && ok;
+    ok = send(server, data, tokens, true) && ok;
+    server.stop(&thread);
+
+    out << (ok ? "PASS" : "FAIL") << "\n";
+    return ok ? 0 : 1;
+}
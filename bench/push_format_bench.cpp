@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * Compares the old if/else loc_key chain in formatNotificationMessage()
+ * against MessageFormatRegistry over a realistic mix of message types.
+ *
+ * Usage: push_format_bench [iterations]
+ */
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QTextStream>
+#include <QVector>
+
+#include "pushmessage.h"
+#include "messageformat.h"
+#include "i18n.h"
+
+// The chain as it was before the registry, kept verbatim for comparison
+static QString formatWithChain(const QString &messageType, const QJsonArray &args)
+{
+    if (messageType == "MESSAGE_TEXT" && args.size() >= 2)
+        return args[1].toString();
+    else if (messageType == "MESSAGE_PHOTO")
+        return N_("sent you a photo");
+    else if (messageType == "MESSAGE_VIDEO")
+        return N_("sent you a video");
+    else if (messageType == "MESSAGE_AUDIO")
+        return N_("sent you an audio message");
+    else if (messageType == "MESSAGE_VOICE_NOTE")
+        return N_("sent you a voice message");
+    else if (messageType == "MESSAGE_STICKER")
+        return N_("sent you a sticker");
+    else if (messageType == "MESSAGE_DOC")
+        return N_("sent you a document");
+    else if (messageType == "MESSAGE_CONTACT")
+        return N_("shared a contact with you");
+    else if (messageType == "MESSAGE_GEO")
+        return N_("sent you a location");
+    else if (messageType == "MESSAGE_NOTEXT")
+        return N_("sent you a message");
+    else if (messageType == "CHAT_MESSAGE_TEXT" && args.size() >= 3)
+        return QString("%1: %2").arg(args[0].toString()).arg(args[2].toString());
+    else if (messageType == "CHAT_MESSAGE_PHOTO")
+        return QString(N_("%1 sent a photo to the group")).arg(args[0].toString());
+    else if (messageType == "CHAT_MESSAGE_VIDEO")
+        return QString(N_("%1 sent a video to the group")).arg(args[0].toString());
+    else if (messageType == "CHAT_CREATED")
+        return QString(N_("%1 invited you to the group")).arg(args[0].toString());
+    else if (messageType == "CHAT_ADD_YOU")
+        return QString(N_("%1 invited you to the group")).arg(args[0].toString());
+    else if (messageType == "NEW_MESSAGE")
+        return N_("You have a new message");
+    else
+        return N_("You have a new message");
+}
+
+struct Sample
+{
+    QString locKey;
+    QJsonArray args;
+    PushMessage message;
+};
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    int iterations = argc > 1 ? QString(argv[1]).toInt() : 1000000;
+
+    // Roughly what a chat app sees: mostly text, some media, a few
+    // group events and the odd type we do not know about
+    struct { const char *locKey; int weight; const char *args; } mix[] = {
+        { "MESSAGE_TEXT", 40, "[\"Alice\",\"Hey there! How are you?\"]" },
+        { "CHAT_MESSAGE_TEXT", 30, "[\"Charlie\",\"My Friends\",\"Anyone up for coffee?\"]" },
+        { "MESSAGE_PHOTO", 8, "[\"Bob\"]" },
+        { "CHAT_MESSAGE_PHOTO", 6, "[\"Dave\",\"Book Club\"]" },
+        { "MESSAGE_VOICE_NOTE", 5, "[\"Erin\"]" },
+        { "MESSAGE_STICKER", 4, "[\"Frank\"]" },
+        { "CHAT_ADD_YOU", 2, "[\"Grace\",\"Hiking\"]" },
+        { "MESSAGE_POLL", 3, "[\"Heidi\"]" },
+        { "NEW_MESSAGE", 2, "[]" },
+    };
+
+    QVector<Sample> samples;
+    for (const auto &entry : mix) {
+        for (int i = 0; i < entry.weight; ++i) {
+            Sample sample;
+            QByteArray payload = QByteArray("{\"message\":{\"loc_key\":\"") + entry.locKey
+                + "\",\"loc_args\":" + entry.args + "}}";
+            sample.message.decode(payload);
+            sample.locKey = PushMessage::toString(sample.message.locKey);
+            for (int a = 0; a < sample.message.locArgCount; ++a) {
+                sample.args.append(sample.message.locArg(a));
+            }
+            samples.append(sample);
+        }
+    }
+
+    QTextStream out(stdout);
+    qint64 checksum = 0;
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        const Sample &sample = samples.at(i % samples.size());
+        checksum += formatWithChain(sample.locKey, sample.args).size();
+    }
+    out << "if/else chain: " << QString::number(double(timer.nsecsElapsed()) / iterations, 'f', 1) << " ns/message\n";
+
+    timer.restart();
+    for (int i = 0; i < iterations; ++i) {
+        const Sample &sample = samples.at(i % samples.size());
+        checksum += MessageFormatRegistry::render(sample.message).size();
+    }
+    out << "registry:      " << QString::number(double(timer.nsecsElapsed()) / iterations, 'f', 1) << " ns/message\n";
+
+    timer.restart();
+    for (int i = 0; i < iterations; ++i) {
+        const Sample &sample = samples.at(i % samples.size());
+        checksum += MessageFormatRegistry::find(sample.message.locKey) != nullptr;
+    }
+    out << "lookup only:   " << QString::number(double(timer.nsecsElapsed()) / iterations, 'f', 1) << " ns/message\n";
+
+    out << "checksum " << checksum << "\n";
+    return 0;
+}
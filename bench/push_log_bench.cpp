@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * Per-push cost of the helper's debug logging with the debug level turned
+ * off, as on a phone:
+ *   qDebug(category)   - the old statements, which format every argument
+ *   qCDebug(category)  - skipped at runtime, arguments never evaluated
+ *   QT_NO_DEBUG_OUTPUT - compiled out (PUSH_LOG_LEVEL=info)
+ *
+ * Usage: push_log_bench [iterations]
+ */
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTextStream>
+
+#include "log_sample.h"
+
+Q_LOGGING_CATEGORY(benchLog, "benchLog", QtInfoMsg)
+
+#define LOG_SEQUENCE logSequenceEager
+#define LOG_DEBUG qDebug
+#include "log_sequence.h"
+#undef LOG_SEQUENCE
+#undef LOG_DEBUG
+
+#define LOG_SEQUENCE logSequenceLazy
+#define LOG_DEBUG qCDebug
+#include "log_sequence.h"
+#undef LOG_SEQUENCE
+#undef LOG_DEBUG
+
+typedef void (*Sequence)(const QLoggingCategory &(*)(), const LogSample &);
+
+static void run(const QString &label, int iterations, const LogSample &sample, Sequence sequence)
+{
+    for (int i = 0; i < 100; ++i) {
+        sequence(benchLog, sample);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        sequence(benchLog, sample);
+    }
+
+    QTextStream out(stdout);
+    out << label << ": " << QString::number(double(timer.nsecsElapsed()) / iterations, 'f', 1) << " ns/push\n";
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    int iterations = argc > 1 ? QString(argv[1]).toInt() : 100000;
+
+    LogSample sample;
+    sample.locKey = "CHAT_MESSAGE_TEXT";
+    sample.locArgs << "Charlie" << "My Friends" << "Anyone up for coffee?";
+    sample.badge = 3;
+    sample.chatId = -345678;
+    sample.summary = "Charlie";
+    sample.body = "Charlie: Anyone up for coffee?";
+    sample.icon = "/home/phablet/.local/share/pushnotification.surajyadav/avatars/345678.jpg";
+    sample.tag = "chat_-345678";
+    sample.outfile = "/tmp/push-helper/out.json";
+    sample.path = "/com/lomiri/Postal/pushnotification_2esurajyadav";
+    sample.cardJson = "{\"notification\":{\"card\":{\"summary\":\"Charlie\",\"body\":\"Charlie: Anyone up "
+                      "for coffee?\",\"icon\":\"/home/phablet/.local/share/pushnotification.surajyadav/"
+                      "avatars/345678.jpg\",\"persist\":true,\"popup\":true,\"actions\":[\"pushnotification:"
+                      "//chat/-345678\"]},\"tag\":\"chat_-345678\",\"vibrate\":true,\"sound\":true,"
+                      "\"emblem-counter\":{\"count\":3,\"visible\":true}}}";
+
+    run("qDebug(category)  ", iterations, sample, logSequenceEager);
+    run("qCDebug(category) ", iterations, sample, logSequenceLazy);
+    run("QT_NO_DEBUG_OUTPUT", iterations, sample, logSequenceStripped);
+
+    return 0;
+}
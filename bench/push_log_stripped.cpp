@@ -0,0 +1,12 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * log_sequence.h built the way a release helper is: debug output is
+ * compiled out before any Qt header is seen.
+ */
+
+#define QT_NO_DEBUG_OUTPUT
+
+#define LOG_SEQUENCE logSequenceStripped
+#define LOG_DEBUG qCDebug
+#include "log_sequence.h"
@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * TokenRegistry at scale: inserts tokens for half as many users, then
+ * measures random lookups, saving the snapshot, loading it back through
+ * mmap, lookups on the freshly mapped snapshot and pruning tokens by value.
+ * Fails unless the loaded registry matches the original and pruned tokens
+ * are gone.
+ *
+ * Usage: push_registry_bench [tokens] [lookups]
+ */
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+#include "tokenregistry.h"
+
+// Token i belongs to user i % users, so a user's tokens are not inserted
+// back to back and lists have to move as they grow
+static QByteArray token(qint64 i)
+{
+    return "device-token-" + QByteArray::number(i, 16).rightJustified(16, '0') + "-lomiri-push";
+}
+
+static qint64 userOf(qint64 i, qint64 users)
+{
+    return 1000000000LL + i % users;
+}
+
+static void report(const QString &label, qint64 ns, qint64 operations, const QString &extra = QString())
+{
+    QTextStream out(stdout);
+    out.setFieldAlignment(QTextStream::AlignLeft);
+    out << qSetFieldWidth(28) << label << qSetFieldWidth(0)
+        << " " << QString::number(ns / 1e6, 'f', 1) << "ms";
+    if (operations > 0) {
+        out << ", " << QString::number(double(ns) / operations, 'f', 1) << " ns/op";
+    }
+    out << extra << "\n";
+}
+
+// Random users, each looked up once per call; returns the tokens found
+static qint64 lookups(const TokenRegistry &registry, qint64 users, int count, quint64 seed)
+{
+    QVector<QByteArray> out;
+    qint64 found = 0;
+    for (int i = 0; i < count; ++i) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        out.clear();
+        found += registry.lookup(1000000000LL + qint64((seed >> 33) % quint64(users)), out);
+    }
+    return found;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    qint64 tokens = argc > 1 ? QString(argv[1]).toLongLong() : 10000000;
+    int lookupCount = argc > 2 ? QString(argv[2]).toInt() : 1000000;
+    qint64 users = qMax<qint64>(1, tokens / 2);
+
+    QTemporaryDir tmp;
+    if (!tmp.isValid()) {
+        qFatal("Cannot create temporary directory");
+    }
+    QString path = tmp.filePath("tokens.bin");
+
+    QTextStream out(stdout);
+    out << "registry: " << tokens << " tokens for " << users << " users\n";
+    bool ok = true;
+
+    TokenRegistry registry;
+    QElapsedTimer timer;
+    timer.start();
+    for (qint64 i = 0; i < tokens; ++i) {
+        registry.insert(userOf(i, users), token(i));
+    }
+    report("insert", timer.nsecsElapsed(), tokens);
+    ok = ok && registry.tokenCount() == tokens && registry.userCount() == users;
+
+    timer.restart();
+    qint64 found = lookups(registry, users, lookupCount, 1);
+    report("lookup", timer.nsecsElapsed(), lookupCount,
+           QString(", %1 tokens/user").arg(double(found) / lookupCount, 0, 'f', 2));
+
+    timer.restart();
+    ok = registry.save(path) && ok;
+    report("save", timer.nsecsElapsed(), 0,
+           QString(", %1 MB").arg(QFileInfo(path).size() / 1e6, 0, 'f', 1));
+
+    TokenRegistry loaded;
+    timer.restart();
+    ok = loaded.load(path) && ok;
+    report("load (mmap)", timer.nsecsElapsed(), 0);
+
+    // First touches fault the mapped pages in
+    timer.restart();
+    qint64 foundMapped = lookups(loaded, users, lookupCount, 1);
+    report("lookup, freshly mapped", timer.nsecsElapsed(), lookupCount);
+    timer.restart();
+    lookups(loaded, users, lookupCount, 1);
+    report("lookup, mapped and warm", timer.nsecsElapsed(), lookupCount);
+    ok = ok && foundMapped == found && loaded.tokenCount() == tokens && loaded.userCount() == users;
+
+    for (qint64 i = 0; i < qMin<qint64>(tokens, 1000); ++i) {
+        qint64 sample = (i * 7919) % tokens;
+        if (!loaded.tokens(userOf(sample, users)).contains(token(sample))) {
+            qWarning("Token %lld missing after load", sample);
+            ok = false;
+            break;
+        }
+    }
+
+    // Pruning by token value checks every shard; the first change to a
+    // mapped shard copies it to the heap
+    int pruneCount = int(qMin<qint64>(tokens, 10000));
+    timer.restart();
+    int pruned = 0;
+    for (int i = 0; i < pruneCount; ++i) {
+        pruned += loaded.removeToken(token(qint64(i) * (tokens / pruneCount)));
+    }
+    report("prune by token", timer.nsecsElapsed(), pruneCount);
+    ok = ok && pruned == pruneCount && loaded.tokenCount() == tokens - pruneCount
+         && !loaded.tokens(userOf(0, users)).contains(token(0));
+
+    timer.restart();
+    for (int i = 0; i < pruneCount; ++i) {
+        loaded.insert(userOf(qint64(i) * (tokens / pruneCount), users), token(qint64(i) * (tokens / pruneCount)));
+    }
+    report("insert after load", timer.nsecsElapsed(), pruneCount);
+    ok = ok && loaded.tokenCount() == tokens && loaded.tokens(userOf(0, users)).contains(token(0));
+
+    out << (ok ? "PASS" : "FAIL") << "\n";
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * PushSender throughput against a local HTTP stub of the push service on
+ * its own thread: a connection per request (what server-example.py does),
+ * one keep-alive connection with one request at a time, and a pool of
+ * pipelined keep-alive connections, with and without injected 503s.
+ * Fails unless every run delivers every message.
+ *
+ * Usage: push_sender_bench [messages]
+ */
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QHash>
+#include <QTextStream>
+#include <QThread>
+
+#include "benchutil.h"
+#include "httpstub.h"
+#include "pushsender.h"
+
+struct Mode
+{
+    const char *label;
+    bool keepAlive;
+    int connections;
+    int pipelineDepth;
+    int maxInFlight;
+    int failEvery;
+};
+
+static bool run(const Mode &mode, HttpStub &server, int messages)
+{
+    server.failEvery = mode.failEvery;
+    server.requests = 0;
+
+    PushSender sender(QUrl(QString("http://127.0.0.1:%1/notify").arg(server.serverPort())),
+                      "pushnotification.surajyadav_pushnotification");
+    sender.setKeepAlive(mode.keepAlive);
+    sender.setConnections(mode.connections);
+    sender.setPipelineDepth(mode.pipelineDepth);
+    sender.setMaxInFlight(mode.maxInFlight);
+    sender.setBackoff(5, 50);
+
+    // Tokens are unique, so they identify the request for its latency
+    QHash<QByteArray, qint64> started;
+    started.reserve(messages);
+    BenchStats latency;
+    QElapsedTimer timer;
+    QObject::connect(&sender, &PushSender::delivered, [&](const QByteArray &token) {
+        latency.add(timer.nsecsElapsed() - started.value(token));
+    });
+
+    QEventLoop loop;
+    QObject::connect(&sender, &PushSender::idle, &loop, &QEventLoop::quit);
+
+    QJsonObject data = PushPayload::textMessage("Alice", "Hey there! How are you?", 123456);
+    timer.start();
+    for (int i = 0; i < messages; ++i) {
+        PushRequest request;
+        request.token = "device-" + QByteArray::number(i);
+        request.data = data;
+        request.replaceTag = "msg_123456";
+        started.insert(request.token, timer.nsecsElapsed());
+        sender.send(request);
+    }
+    loop.exec();
+    qint64 elapsed = timer.nsecsElapsed();
+
+    PushSenderStats stats = sender.stats();
+    latency.print(mode.label);
+    QTextStream out(stdout);
+    out << "    " << QString::number(messages / (elapsed / 1e9), 'f', 0) << " msg/s"
+        << ", delivered " << stats.delivered << ", failed " << stats.failed
+        << ", retries " << stats.retries << ", connections " << stats.connects
+        << ", server requests " << server.requests.load() << "\n";
+
+    return stats.delivered == messages && stats.failed == 0 && (mode.failEvery == 0 || stats.retries > 0);
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    int messages = argc > 1 ? QString(argv[1]).toInt() : 5000;
+
+    QThread thread;
+    HttpStub server;
+    if (!server.start(&thread)) {
+        qFatal("Cannot listen on loopback");
+    }
+
+    const Mode modes[] = {
+        { "connection per request", false, 1, 1, 1, 0 },
+        { "keep-alive, serial", true, 1, 1, 1, 0 },
+        { "pooled + pipelined", true, 4, 16, 64, 0 },
+        { "pooled, 2% 503", true, 4, 16, 64, 50 },
+    };
+
+    QTextStream out(stdout);
+    out << "sending " << messages << " messages per run\n";
+    bool ok = true;
+    for (const Mode &mode : modes) {
+        ok = run(mode, server, messages) && ok;
+    }
+    out << (ok ? "PASS" : "FAIL") << "\n";
+
+    server.stop(&thread);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * Cold start of push vs. push-lite: time from spawning the process to
+ * main() (from the helper's own trace) and to exit.
+ *
+ * Usage: push_startup_bench [iterations]
+ */
+
+#include <QCoreApplication>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QDebug>
+
+#include <chrono>
+
+#include "benchutil.h"
+
+static const char *PAYLOAD =
+    "{\"message\":{\"loc_key\":\"MESSAGE_TEXT\","
+    "\"loc_args\":[\"Alice\",\"Hey there! How are you?\"],"
+    "\"badge\":1,\"custom\":{\"from_id\":\"123456\"}}}";
+
+static qint64 monotonicNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Durations of the "exec to main()" events in every trace under dir
+static void readStartupEvents(const QString &dir, BenchStats &stats)
+{
+    QDirIterator it(dir, QStringList() << "push-trace.json", QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        QFile file(it.next());
+        if (!file.open(QIODevice::ReadOnly)) {
+            continue;
+        }
+
+        // The trace leaves off the closing bracket after its last event
+        QByteArray data = file.readAll().trimmed();
+        if (data.endsWith(',')) {
+            data.chop(1);
+        }
+        data.append(']');
+
+        const QJsonArray events = QJsonDocument::fromJson(data).array();
+        for (const QJsonValue &value : events) {
+            QJsonObject event = value.toObject();
+            if (event["name"].toString() == "exec to main()") {
+                stats.add(qint64(event["dur"].toDouble() * 1000));
+            }
+        }
+        file.remove();
+    }
+}
+
+static void run(const QString &label, const QString &program, const QString &infile, int iterations,
+                const QTemporaryDir &tmp)
+{
+    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+    env.insert("XDG_DATA_HOME", tmp.filePath("data"));
+    env.insert("PUSH_HELPER_SOCKET", tmp.filePath("push.sock"));
+    // Startup only: D-Bus calls fail fast instead of reaching a real bus
+    env.insert("DBUS_SESSION_BUS_ADDRESS", "unix:path=" + tmp.filePath("no-bus"));
+
+    // Warm the page cache so both binaries start from the same place
+    QProcess::execute(program, QStringList() << infile << tmp.filePath("out.json"));
+
+    BenchStats toExit;
+    for (int i = 0; i < iterations; ++i) {
+        QProcess process;
+        process.setProcessEnvironment(env);
+        QElapsedTimer timer;
+        timer.start();
+        process.start(program, QStringList() << infile << tmp.filePath("out.json"));
+        if (!process.waitForFinished(10000) || process.exitCode() != 0) {
+            qWarning() << label << "run failed";
+        }
+        toExit.add(timer.nsecsElapsed());
+    }
+
+    // A second pass with tracing on, so its file write does not count above
+    env.insert("PUSH_HELPER_TRACE", "1");
+    for (int i = 0; i < iterations; ++i) {
+        QProcess process;
+        env.insert("PUSH_HELPER_SPAWN_NS", QString::number(monotonicNs()));
+        process.setProcessEnvironment(env);
+        process.start(program, QStringList() << infile << tmp.filePath("out.json"));
+        process.waitForFinished(10000);
+    }
+    BenchStats toMain;
+    readStartupEvents(tmp.filePath("data"), toMain);
+
+    toMain.print(label + " to main()");
+    toExit.print(label + " to exit");
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    int iterations = argc > 1 ? QString(argv[1]).toInt() : 50;
+
+    QTemporaryDir tmp;
+    if (!tmp.isValid()) {
+        qFatal("Cannot create temporary directory");
+    }
+
+    QString infile = tmp.filePath("in.json");
+    QFile in(infile);
+    if (!in.open(QIODevice::WriteOnly)) {
+        qFatal("Cannot write payload");
+    }
+    in.write(PAYLOAD);
+    in.close();
+
+    run("push", PUSH_EXECUTABLE, infile, iterations, tmp);
+    run("push-lite", PUSH_LITE_EXECUTABLE, infile, iterations, tmp);
+
+    return 0;
+}
@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * Concurrent helpers on one auxdb: starts N push processes at once, for
+ * several rounds, each updating the unread count of its own chat. After
+ * the last round the badge total must equal the sum of the last counts
+ * written, and no helper may have hit "database is locked".
+ *
+ * Usage: push_stress_bench [helpers] [rounds]
+ */
+
+#include <QCoreApplication>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcess>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QLoggingCategory>
+
+#include <memory>
+#include <vector>
+
+#include "auxdatabase.h"
+#include "benchutil.h"
+
+static const qint64 FIRST_CHAT = 100000;
+
+static int badgeFor(int helper, int round)
+{
+    return round + helper % 3 + 1;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    int helpers = argc > 1 ? QString(argv[1]).toInt() : 16;
+    int rounds = argc > 2 ? QString(argv[2]).toInt() : 10;
+
+    QTemporaryDir tmp;
+    if (!tmp.isValid()) {
+        qFatal("Cannot create temporary directory");
+    }
+
+    // A private database, no daemon to forward to and no session bus, so
+    // the D-Bus calls after the outfile fail fast. SQLite errors show up
+    // as auxdb warnings in the helper output.
+    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+    env.insert("XDG_DATA_HOME", tmp.filePath("data"));
+    env.insert("PUSH_HELPER_SOCKET", tmp.filePath("push.sock"));
+    env.insert("DBUS_SESSION_BUS_ADDRESS", "unix:path=" + tmp.filePath("no-bus"));
+
+    for (int h = 0; h < helpers; ++h) {
+        for (int r = 0; r < rounds; ++r) {
+            QString filename = tmp.filePath(QString("in_%1_%2.json").arg(h).arg(r));
+            QFile file(filename);
+            if (!file.open(QIODevice::WriteOnly)) {
+                qFatal("Cannot write payload");
+            }
+            file.write(QString("{\"message\":{\"loc_key\":\"MESSAGE_TEXT\","
+                               "\"loc_args\":[\"Sender %1\",\"Round %2\"],"
+                               "\"badge\":%3,\"custom\":{\"from_id\":\"%4\"}}}")
+                           .arg(h).arg(r).arg(badgeFor(h, r)).arg(FIRST_CHAT + h)
+                           .toUtf8());
+        }
+    }
+
+    BenchStats roundTimes;
+    int failures = 0;
+    int lockErrors = 0;
+    for (int r = 0; r < rounds; ++r) {
+        std::vector<std::unique_ptr<QProcess>> processes;
+        QElapsedTimer timer;
+        timer.start();
+        for (int h = 0; h < helpers; ++h) {
+            processes.emplace_back(new QProcess);
+            QProcess *process = processes.back().get();
+            process->setProcessEnvironment(env);
+            process->setProcessChannelMode(QProcess::MergedChannels);
+            process->start(PUSH_EXECUTABLE, QStringList()
+                           << tmp.filePath(QString("in_%1_%2.json").arg(h).arg(r))
+                           << tmp.filePath(QString("out_%1.json").arg(h)));
+        }
+
+        for (const auto &process : processes) {
+            if (!process->waitForFinished(30000) || process->exitStatus() != QProcess::NormalExit
+                    || process->exitCode() != 0) {
+                ++failures;
+            }
+            lockErrors += process->readAll().count("database is locked");
+        }
+        roundTimes.add(timer.nsecsElapsed());
+    }
+
+    // Check the result through a connection of our own
+    QString databaseDirectory;
+    QDirIterator it(tmp.filePath("data"), QStringList() << "auxdb.sqlite", QDir::Files, QDirIterator::Subdirectories);
+    if (it.hasNext()) {
+        databaseDirectory = QFileInfo(it.next()).path();
+    }
+    if (databaseDirectory.isEmpty()) {
+        qFatal("No auxdb.sqlite was written");
+    }
+
+    QLoggingCategory::setFilterRules("auxdb=false\navatarMapTable=false\navatarIndex=false");
+    qint32 expected = 0;
+    qint32 total = 0;
+    int wrongChats = 0;
+    {
+        AuxDatabase db(databaseDirectory, databaseDirectory);
+        AvatarMapTable *table = db.getAvatarMapTable();
+        if (!table) {
+            qFatal("Cannot open auxdb");
+        }
+        for (int h = 0; h < helpers; ++h) {
+            expected += badgeFor(h, rounds - 1);
+            if (table->getUnreadCount(FIRST_CHAT + h) != badgeFor(h, rounds - 1)) {
+                ++wrongChats;
+            }
+        }
+        total = table->getTotalUnread();
+    }
+
+    QTextStream out(stdout);
+    roundTimes.print(QString("%1 concurrent helpers").arg(helpers));
+    out << "badge total " << total << ", expected " << expected
+        << ", wrong chats " << wrongChats
+        << ", failed helpers " << failures
+        << ", lock errors " << lockErrors << "\n";
+
+    bool ok = total == expected && wrongChats == 0 && failures == 0 && lockErrors == 0;
+    out << (ok ? "PASS" : "FAIL") << "\n";
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * AuxDatabase storage backend on Qt SQL and the QSQLITE driver plugin
+ */
+
+#include "auxdatabase.h"
+
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QDebug>
+#include <QLoggingCategory>
+
+Q_DECLARE_LOGGING_CATEGORY(auxdb)
+
+AuxDatabase::~AuxDatabase()
+{
+    // Prepared statements must be released before the connection closes
+    qDeleteAll(m_preparedQueries);
+    m_preparedQueries.clear();
+    
+    if (m_database.isOpen()) {
+        m_database.close();
+    }
+}
+
+bool AuxDatabase::open()
+{
+    m_database = QSqlDatabase::addDatabase("QSQLITE", "auxdb");
+    m_database.setDatabaseName(m_databasePath);
+    
+    if (!m_database.open()) {
+        qCWarning(auxdb) << "Cannot open database:" << m_database.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+bool AuxDatabase::isOpen() const
+{
+    return m_database.isOpen();
+}
+
+bool AuxDatabase::execute(const QString &sql)
+{
+    QSqlQuery query(m_database);
+    if (!query.exec(sql)) {
+        logSqlError(query);
+        return false;
+    }
+    return true;
+}
+
+int AuxDatabase::queryInt(const QString &sql)
+{
+    QSqlQuery query(m_database);
+    if (query.exec(sql) && query.next()) {
+        return query.value(0).toInt();
+    }
+    return 0;
+}
+
+QSqlDatabase *AuxDatabase::getDB()
+{
+    if (m_database.isOpen()) {
+        return &m_database;
+    }
+    return nullptr;
+}
+
+QSqlQuery *AuxDatabase::preparedQuery(const QString &sql)
+{
+    if (!m_database.isOpen()) {
+        return nullptr;
+    }
+    
+    QSqlQuery *query = m_preparedQueries.value(sql);
+    if (!query) {
+        query = new QSqlQuery(m_database);
+        if (!query->prepare(sql)) {
+            logSqlError(*query);
+            delete query;
+            return nullptr;
+        }
+        m_preparedQueries.insert(sql, query);
+    }
+    return query;
+}
+
+void AuxDatabase::logSqlError(QSqlQuery &q) const
+{
+    qCWarning(auxdb) << "SQLite error:" << q.lastError().text();
+    qCDebug(auxdb) << "SQLite query:" << q.lastQuery();
+}
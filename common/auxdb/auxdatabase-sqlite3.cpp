@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * AuxDatabase storage backend on libsqlite3
+ *
+ * Talks to SQLite directly: no driver plugin to locate and load at
+ * startup, and values are bound and read without going through QVariant.
+ */
+
+#include "auxdatabase.h"
+
+#include <QDebug>
+#include <QLoggingCategory>
+
+#include <sqlite3.h>
+
+Q_DECLARE_LOGGING_CATEGORY(auxdb)
+
+AuxDatabase::~AuxDatabase()
+{
+    // Prepared statements must be released before the connection closes
+    for (sqlite3_stmt *statement : qAsConst(m_statements)) {
+        sqlite3_finalize(statement);
+    }
+    m_statements.clear();
+    
+    if (m_sqlite) {
+        sqlite3_close(m_sqlite);
+        m_sqlite = nullptr;
+    }
+}
+
+bool AuxDatabase::open()
+{
+    // One connection per process, used from the main thread only
+    int flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX;
+    if (sqlite3_open_v2(m_databasePath.toUtf8().constData(), &m_sqlite, flags, nullptr) != SQLITE_OK) {
+        qCWarning(auxdb) << "Cannot open database:" << (m_sqlite ? sqlite3_errmsg(m_sqlite) : "out of memory");
+        sqlite3_close(m_sqlite);
+        m_sqlite = nullptr;
+        return false;
+    }
+    return true;
+}
+
+bool AuxDatabase::isOpen() const
+{
+    return m_sqlite != nullptr;
+}
+
+bool AuxDatabase::execute(const QString &sql)
+{
+    if (!m_sqlite) {
+        return false;
+    }
+    
+    QByteArray utf8 = sql.toUtf8();
+    if (sqlite3_exec(m_sqlite, utf8.constData(), nullptr, nullptr, nullptr) != SQLITE_OK) {
+        logSqliteError(utf8.constData());
+        return false;
+    }
+    return true;
+}
+
+int AuxDatabase::queryInt(const QString &sql)
+{
+    if (!m_sqlite) {
+        return 0;
+    }
+    
+    int value = 0;
+    sqlite3_stmt *statement = nullptr;
+    if (sqlite3_prepare_v2(m_sqlite, sql.toUtf8().constData(), -1, &statement, nullptr) == SQLITE_OK
+            && sqlite3_step(statement) == SQLITE_ROW) {
+        value = sqlite3_column_int(statement, 0);
+    }
+    sqlite3_finalize(statement);
+    return value;
+}
+
+sqlite3_stmt *AuxDatabase::preparedStatement(const char *sql)
+{
+    if (!m_sqlite) {
+        return nullptr;
+    }
+    
+    sqlite3_stmt *statement = m_statements.value(sql);
+    if (!statement) {
+        // SQLITE_PREPARE_PERSISTENT tells SQLite the statement is reused
+        // for the life of the connection
+        if (sqlite3_prepare_v3(m_sqlite, sql, -1, SQLITE_PREPARE_PERSISTENT, &statement, nullptr) != SQLITE_OK) {
+            logSqliteError(sql);
+            sqlite3_finalize(statement);
+            return nullptr;
+        }
+        m_statements.insert(sql, statement);
+    }
+    return statement;
+}
+
+void AuxDatabase::logSqliteError(const char *sql) const
+{
+    qCWarning(auxdb) << "SQLite error:" << sqlite3_errmsg(m_sqlite);
+    qCDebug(auxdb) << "SQLite query:" << sql;
+}
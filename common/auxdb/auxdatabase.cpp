@@ -2,16 +2,20 @@
  * Copyright (C) 2025 Suraj Yadav
  *
  * AuxDatabase implementation
+ *
+ * Schema setup, migrations and transactions; everything that talks to the
+ * database goes through the backend primitives in auxdatabase-qtsql.cpp
+ * or auxdatabase-sqlite3.cpp.
  */
 
 #include "auxdatabase.h"
+#include "auxdb-sql.h"
+#include "avatarindex.h"
 
-#include <QSqlDatabase>
-#include <QSqlQuery>
-#include <QSqlError>
 #include <QDir>
 #include <QFile>
 #include <QStandardPaths>
+#include <QStringList>
 #include <QDebug>
 #include <QLoggingCategory>
 
@@ -22,51 +26,104 @@ AuxDatabase::AuxDatabase(const QString &databaseDirectory, const QString &assets
     , m_databaseDirectory(databaseDirectory)
     , m_assetsDirectory(assetsDirectory)
     , m_avatarMapTable(nullptr)
+    , m_chatBurstTable(nullptr)
+    , m_transactionDepth(0)
+    , m_avatarIndexStale(false)
 {
     m_databasePath = m_databaseDirectory + "/auxdb.sqlite";
     
-    qDebug(auxdb) << "AuxDatabase initialized";
-    qDebug(auxdb) << "Database directory:" << m_databaseDirectory;
-    qDebug(auxdb) << "Database path:" << m_databasePath;
+    qCDebug(auxdb) << "AuxDatabase initialized";
+    qCDebug(auxdb) << "Database directory:" << m_databaseDirectory;
+    qCDebug(auxdb) << "Database path:" << m_databasePath;
     
     if (initDatabase()) {
         m_avatarMapTable = new AvatarMapTable(this, this);
-        qDebug(auxdb) << "Database initialization successful";
+        m_chatBurstTable = new ChatBurstTable(this, this);
+        qCDebug(auxdb) << "Database initialization successful";
+        
+        // Databases from before the avatar index need one to start with
+        if (!QFile::exists(avatarIndexPath())) {
+            transaction();
+            avatarsChanged();
+            commit();
+        }
     } else {
-        qWarning(auxdb) << "Database initialization failed";
+        qCWarning(auxdb) << "Database initialization failed";
     }
 }
 
-AuxDatabase::~AuxDatabase()
+QString AuxDatabase::avatarIndexPath() const
 {
-    if (m_database.isOpen()) {
-        m_database.close();
+    return AvatarIndex::pathIn(m_databaseDirectory);
+}
+
+void AuxDatabase::avatarsChanged()
+{
+    // The index is written under the write lock, so helpers replace it
+    // in the order they commit
+    if (m_transactionDepth > 0) {
+        m_avatarIndexStale = true;
+    } else if (transaction()) {
+        m_avatarIndexStale = true;
+        commit();
     }
 }
 
+void AuxDatabase::rebuildAvatarIndex()
+{
+    if (m_avatarMapTable->rebuildAvatarIndex()) {
+        return;
+    }
+    
+    // A stale index would keep answering with old paths; without one
+    // readers fall back to the database
+    qCWarning(auxdb) << "Cannot rebuild avatar index, removing it";
+    QFile::remove(avatarIndexPath());
+}
+
 bool AuxDatabase::initDatabase()
 {
     // Create database directory if it doesn't exist
     QDir dir;
     if (!dir.exists(m_databaseDirectory)) {
         if (!dir.mkpath(m_databaseDirectory)) {
-            qWarning(auxdb) << "Unable to create database directory:" << m_databaseDirectory;
+            qCWarning(auxdb) << "Unable to create database directory:" << m_databaseDirectory;
             return false;
         }
     }
     
-    // Initialize SQLite database
-    m_database = QSqlDatabase::addDatabase("QSQLITE", "auxdb");
-    m_database.setDatabaseName(m_databasePath);
-    
-    if (!m_database.open()) {
-        qWarning(auxdb) << "Cannot open database:" << m_database.lastError().text();
+    if (!open()) {
         return false;
     }
     
+    // Several push helpers can run at once; wait for each other's write
+    // transactions instead of failing with "database is locked". This has
+    // to come first, switching to WAL below already needs a lock.
+    bool ok = false;
+    int busyTimeout = qEnvironmentVariable("AUXDB_BUSY_TIMEOUT").toInt(&ok);
+    execute(QString("PRAGMA busy_timeout = %1").arg(ok ? busyTimeout : DEFAULT_BUSY_TIMEOUT_MS));
+    
     // Enable foreign keys
-    QSqlQuery query(m_database);
-    query.exec("PRAGMA foreign_keys = ON");
+    execute("PRAGMA foreign_keys = ON");
+    
+    // The unread_total triggers must also see the implicit delete of a
+    // REPLACE conflict resolution, which only happens with recursive triggers
+    execute("PRAGMA recursive_triggers = ON");
+    
+    // WAL turns each commit into a single append to the log instead of a
+    // rollback journal plus database write, and with synchronous=NORMAL it
+    // only fsyncs at checkpoints. Both knobs can be overridden for testing.
+    execute("PRAGMA journal_mode = WAL");
+    
+    QString synchronous = qEnvironmentVariable("AUXDB_SYNCHRONOUS", "NORMAL").toUpper();
+    if (!QStringList({ "OFF", "NORMAL", "FULL", "EXTRA" }).contains(synchronous)) {
+        qCWarning(auxdb) << "Ignoring invalid AUXDB_SYNCHRONOUS:" << synchronous;
+        synchronous = "NORMAL";
+    }
+    execute(QString("PRAGMA synchronous = %1").arg(synchronous));
+    
+    qint64 mmapSize = qEnvironmentVariable("AUXDB_MMAP_SIZE").toLongLong(&ok);
+    execute(QString("PRAGMA mmap_size = %1").arg(ok ? mmapSize : DEFAULT_MMAP_SIZE));
     
     // Check if migration is needed
     return migrateDatabase();
@@ -75,67 +132,129 @@ bool AuxDatabase::initDatabase()
 bool AuxDatabase::migrateDatabase()
 {
     int currentVersion = getDatabaseVersion();
-    qDebug(auxdb) << "Current database version:" << currentVersion;
+    qCDebug(auxdb) << "Current database version:" << currentVersion;
+    
+    if (currentVersion >= CURRENT_DB_VERSION) {
+        return true;
+    }
+    
+    // Another helper may be migrating the same file right now; take the
+    // write lock and look at the version again before changing anything
+    if (!execute("BEGIN IMMEDIATE")) {
+        return false;
+    }
+    currentVersion = getDatabaseVersion();
     
     if (currentVersion < CURRENT_DB_VERSION) {
-        qDebug(auxdb) << "Migrating database from version" << currentVersion << "to" << CURRENT_DB_VERSION;
+        qCDebug(auxdb) << "Migrating database from version" << currentVersion << "to" << CURRENT_DB_VERSION;
         
         // Apply migrations
         if (currentVersion < 1) {
-            // Initial schema
-            QSqlQuery query(m_database);
-            if (!query.exec("CREATE TABLE IF NOT EXISTS `chatlist_map` ("
-                           "`id` INTEGER NOT NULL UNIQUE, "
-                           "`path` TEXT NOT NULL, "
-                           "PRIMARY KEY(id))")) {
-                logSqlError(query);
-                return false;
+            for (const char *statement : AuxDbSql::MIGRATION_V1) {
+                if (!execute(statement)) {
+                    execute("ROLLBACK");
+                    return false;
+                }
             }
         }
         
         if (currentVersion < 2) {
-            // Add unread_messages column
-            QSqlQuery query(m_database);
-            if (!query.exec("ALTER TABLE `chatlist_map` ADD COLUMN `unread_messages` INTEGER DEFAULT 0")) {
-                logSqlError(query);
-                return false;
+            for (const char *statement : AuxDbSql::MIGRATION_V2) {
+                if (!execute(statement)) {
+                    execute("ROLLBACK");
+                    return false;
+                }
+            }
+        }
+        
+        if (currentVersion < 3) {
+            for (const char *statement : AuxDbSql::MIGRATION_V3) {
+                if (!execute(statement)) {
+                    execute("ROLLBACK");
+                    return false;
+                }
+            }
+        }
+        
+        if (currentVersion < 4) {
+            for (const char *statement : AuxDbSql::MIGRATION_V4) {
+                if (!execute(statement)) {
+                    execute("ROLLBACK");
+                    return false;
+                }
             }
         }
         
         setDatabaseVersion(CURRENT_DB_VERSION);
-        qDebug(auxdb) << "Database migration completed";
+        qCDebug(auxdb) << "Database migration completed";
     }
     
+    if (!execute("COMMIT")) {
+        execute("ROLLBACK");
+        return false;
+    }
     return true;
 }
 
 int AuxDatabase::getDatabaseVersion()
 {
-    QSqlQuery query(m_database);
-    if (query.exec("PRAGMA user_version")) {
-        if (query.next()) {
-            return query.value(0).toInt();
-        }
-    }
-    return 0;
+    return queryInt("PRAGMA user_version");
 }
 
 void AuxDatabase::setDatabaseVersion(int version)
 {
-    QSqlQuery query(m_database);
-    query.exec(QString("PRAGMA user_version = %1").arg(version));
+    execute(QString("PRAGMA user_version = %1").arg(version));
 }
 
-QSqlDatabase *AuxDatabase::getDB()
+bool AuxDatabase::transaction()
 {
-    if (m_database.isOpen()) {
-        return &m_database;
+    if (!isOpen()) {
+        return false;
+    }
+    
+    // Nested calls join the outer transaction, so bulk table updates can
+    // also be grouped by the caller
+    if (m_transactionDepth > 0) {
+        ++m_transactionDepth;
+        return true;
+    }
+    
+    if (!execute("BEGIN IMMEDIATE")) {
+        qCWarning(auxdb) << "Cannot begin transaction";
+        return false;
     }
-    return nullptr;
+    m_transactionDepth = 1;
+    return true;
 }
 
-void AuxDatabase::logSqlError(QSqlQuery &q) const
+bool AuxDatabase::commit()
 {
-    qDebug(auxdb) << "SQLite error:" << q.lastError().text();
-    qDebug(auxdb) << "SQLite query:" << q.lastQuery();
+    if (!isOpen() || m_transactionDepth == 0) {
+        return false;
+    }
+    
+    if (--m_transactionDepth > 0) {
+        return true;
+    }
+    
+    // The index is renamed into place while we still hold the write lock;
+    // after COMMIT another helper could replace it with a newer one first,
+    // and ours would then overwrite it with older rows
+    bool avatarsChanged = m_avatarIndexStale;
+    m_avatarIndexStale = false;
+    if (avatarsChanged) {
+        rebuildAvatarIndex();
+    }
+    
+    if (!execute("COMMIT")) {
+        qCWarning(auxdb) << "Cannot commit transaction";
+        
+        // The index already holds the rows that are about to roll back
+        if (avatarsChanged) {
+            QFile::remove(avatarIndexPath());
+        }
+        execute("ROLLBACK");
+        return false;
+    }
+    return true;
 }
@@ -7,13 +7,22 @@
 #pragma once
 
 #include <QObject>
+#include <QString>
+#include <QDir>
+#include <QHash>
+
+// The storage backend is chosen at build time with AUXDB_BACKEND
+#ifdef AUXDB_SQLITE3
+struct sqlite3;
+struct sqlite3_stmt;
+#else
 #include <QSqlDatabase>
 #include <QSqlQuery>
 #include <QSqlError>
-#include <QString>
-#include <QDir>
+#endif
 
 #include "avatarmaptable.h"
+#include "chatbursttable.h"
 
 class AuxDatabase : public QObject
 {
@@ -23,10 +32,34 @@ public:
     explicit AuxDatabase(const QString &databaseDirectory, const QString &assetsDirectory, QObject *parent = nullptr);
     ~AuxDatabase();
     
+#ifdef AUXDB_SQLITE3
+    // Long-lived prepared statement for sql, which must be one of the
+    // AuxDbSql constants. Bind and step it, then sqlite3_reset() it.
+    sqlite3_stmt *preparedStatement(const char *sql);
+    void logSqliteError(const char *sql) const;
+#else
     QSqlDatabase *getDB();
     void logSqlError(QSqlQuery &q) const;
     
+    // Long-lived prepared statement for sql, prepared on first use and
+    // owned by the database. Bind and exec it, then finish() it when done.
+    QSqlQuery *preparedQuery(const QString &sql);
+#endif
+    
+    // Group several table updates into one write transaction; calls nest.
+    // The write lock is taken up front, so concurrent helpers queue on the
+    // busy timeout instead of failing to upgrade a read transaction.
+    bool transaction();
+    bool commit();
+    
+    // The avatar index is rebuilt once, when the outermost transaction
+    // commits: written and renamed into place under the write lock just
+    // before COMMIT, and removed again if COMMIT fails
+    void avatarsChanged();
+    
     AvatarMapTable *getAvatarMapTable() { return m_avatarMapTable; }
+    ChatBurstTable *getChatBurstTable() { return m_chatBurstTable; }
+    QString avatarIndexPath() const;
 
 private:
     bool initDatabase();
@@ -34,12 +67,34 @@ private:
     int getDatabaseVersion();
     void setDatabaseVersion(int version);
     
+    // Backend primitives, see auxdatabase-qtsql.cpp and auxdatabase-sqlite3.cpp
+    bool open();
+    bool isOpen() const;
+    bool execute(const QString &sql);
+    int queryInt(const QString &sql);
+    void rebuildAvatarIndex();
+    
     QString m_databaseDirectory;
     QString m_assetsDirectory;
     QString m_databasePath;
-    QSqlDatabase m_database;
     
     AvatarMapTable *m_avatarMapTable;
+    ChatBurstTable *m_chatBurstTable;
+    int m_transactionDepth;
+    bool m_avatarIndexStale;
+    
+#ifdef AUXDB_SQLITE3
+    sqlite3 *m_sqlite = nullptr;
+    QHash<const char *, sqlite3_stmt *> m_statements;
+#else
+    QSqlDatabase m_database;
+    QHash<QString, QSqlQuery *> m_preparedQueries;
+#endif
+    
+    static const int CURRENT_DB_VERSION = 4;
+    static constexpr qint64 DEFAULT_MMAP_SIZE = 8 * 1024 * 1024;
     
-    static const int CURRENT_DB_VERSION = 2;
+    // How long a helper waits for another process's write transaction
+    // before giving up with SQLITE_BUSY; AUXDB_BUSY_TIMEOUT overrides it
+    static constexpr int DEFAULT_BUSY_TIMEOUT_MS = 2000;
 };
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * SQL shared by the auxdb storage backends
+ *
+ * Named parameters are numbered by first appearance, so the same text
+ * binds by name through QSqlQuery and by index through sqlite3_bind_*().
+ * The constants have a single address, which the sqlite3 backend uses as
+ * its prepared statement cache key.
+ */
+
+#pragma once
+
+namespace AuxDbSql {
+
+// Version 1: initial schema
+inline constexpr const char *MIGRATION_V1[] = {
+    "CREATE TABLE IF NOT EXISTS `chatlist_map` ("
+    "`id` INTEGER NOT NULL UNIQUE, "
+    "`path` TEXT NOT NULL, "
+    "PRIMARY KEY(id))",
+};
+
+// Version 2: unread_messages column
+inline constexpr const char *MIGRATION_V2[] = {
+    "ALTER TABLE `chatlist_map` ADD COLUMN `unread_messages` INTEGER DEFAULT 0",
+};
+
+// Version 3: keep the total unread count in a single row maintained by
+// triggers, so reading the badge total is O(1)
+inline constexpr const char *MIGRATION_V3[] = {
+    "CREATE TABLE IF NOT EXISTS `unread_total` ("
+    "`id` INTEGER NOT NULL CHECK(id = 0), "
+    "`total` INTEGER NOT NULL DEFAULT 0, "
+    "PRIMARY KEY(id))",
+    "INSERT OR REPLACE INTO unread_total(id, total) "
+    "SELECT 0, COALESCE(SUM(unread_messages), 0) FROM chatlist_map",
+    "CREATE TRIGGER IF NOT EXISTS `chatlist_map_unread_insert` "
+    "AFTER INSERT ON chatlist_map BEGIN "
+    "UPDATE unread_total SET total = total + COALESCE(NEW.unread_messages, 0) WHERE id = 0; "
+    "END",
+    "CREATE TRIGGER IF NOT EXISTS `chatlist_map_unread_update` "
+    "AFTER UPDATE OF unread_messages ON chatlist_map BEGIN "
+    "UPDATE unread_total SET total = total + COALESCE(NEW.unread_messages, 0) "
+    "- COALESCE(OLD.unread_messages, 0) WHERE id = 0; "
+    "END",
+    "CREATE TRIGGER IF NOT EXISTS `chatlist_map_unread_delete` "
+    "AFTER DELETE ON chatlist_map BEGIN "
+    "UPDATE unread_total SET total = total - COALESCE(OLD.unread_messages, 0) WHERE id = 0; "
+    "END",
+};
+
+// Version 4: per-chat message bursts for notification coalescing, see
+// ChatBurstTable
+inline constexpr const char *MIGRATION_V4[] = {
+    "CREATE TABLE IF NOT EXISTS `chat_burst` ("
+    "`id` INTEGER NOT NULL, "
+    "`started` INTEGER NOT NULL, "
+    "`count` INTEGER NOT NULL, "
+    "`lines` TEXT NOT NULL, "
+    "PRIMARY KEY(id))",
+};
+
+inline constexpr char SELECT_AVATAR[] =
+    "SELECT path FROM chatlist_map WHERE id = :id";
+
+// Everything that goes into the avatar index, see AvatarIndex
+inline constexpr char SELECT_AVATARS[] =
+    "SELECT id, path FROM chatlist_map WHERE path != ''";
+
+// Upserts only touch the column being changed, so the row is updated in
+// place and the other column keeps its value without a second lookup
+inline constexpr char UPSERT_AVATAR[] =
+    "INSERT INTO chatlist_map(id, path) VALUES(:id, :path) "
+    "ON CONFLICT(id) DO UPDATE SET path = excluded.path";
+inline constexpr char UPSERT_UNREAD[] =
+    "INSERT INTO chatlist_map(id, path, unread_messages) VALUES(:id, '', :unread_messages) "
+    "ON CONFLICT(id) DO UPDATE SET unread_messages = excluded.unread_messages";
+
+inline constexpr char SELECT_UNREAD[] =
+    "SELECT unread_messages FROM chatlist_map WHERE id = :id";
+
+// Maintained by the chatlist_map triggers, see MIGRATION_V3
+inline constexpr char SELECT_TOTAL_UNREAD[] =
+    "SELECT total FROM unread_total WHERE id = 0";
+
+inline constexpr char RESET_UNREAD[] =
+    "UPDATE chatlist_map SET unread_messages = 0";
+
+inline constexpr char SELECT_CHAT_BURST[] =
+    "SELECT started, count, lines FROM chat_burst WHERE id = :id";
+inline constexpr char UPSERT_CHAT_BURST[] =
+    "INSERT INTO chat_burst(id, started, count, lines) VALUES(:id, :started, :count, :lines) "
+    "ON CONFLICT(id) DO UPDATE SET started = excluded.started, count = excluded.count, lines = excluded.lines";
+
+} // namespace AuxDbSql
@@ -0,0 +1,208 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * AvatarIndex implementation
+ */
+
+#include "avatarindex.h"
+#include "trace.h"
+
+#include <QSaveFile>
+#include <QDebug>
+#include <QLoggingCategory>
+
+#include <algorithm>
+#include <cstring>
+
+#include <sys/stat.h>
+
+Q_LOGGING_CATEGORY(avatarIndex, "avatarIndex")
+
+namespace {
+
+const char Magic[4] = { 'A', 'V', 'X', '1' };
+
+struct Header
+{
+    char magic[4];
+    quint32 count;
+    quint32 poolSize;
+    quint32 reserved;
+};
+
+// Identifies the file currently at path; a rebuilt index is a new inode
+bool fileStamp(const QString &path, quint64 &inode, qint64 &modified)
+{
+    struct stat st;
+    if (stat(QFile::encodeName(path).constData(), &st) != 0) {
+        return false;
+    }
+    inode = quint64(st.st_ino);
+    modified = qint64(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    return true;
+}
+
+} // namespace
+
+AvatarIndex::AvatarIndex()
+    : m_inode(0)
+    , m_modified(0)
+    , m_count(0)
+    , m_ids(nullptr)
+    , m_offsets(nullptr)
+    , m_pool(nullptr)
+{
+}
+
+AvatarIndex::~AvatarIndex()
+{
+    close();
+}
+
+QString AvatarIndex::pathIn(const QString &databaseDirectory)
+{
+    return databaseDirectory + "/avatar-index.bin";
+}
+
+bool AvatarIndex::open(const QString &path)
+{
+    quint64 inode;
+    qint64 modified;
+    if (!fileStamp(path, inode, modified)) {
+        close();
+        return false;
+    }
+    if (isOpen() && m_file.fileName() == path && inode == m_inode && modified == m_modified) {
+        return true;
+    }
+
+    TRACE_SCOPE("AvatarIndex::open");
+    close();
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        qCWarning(avatarIndex) << "Cannot open avatar index:" << path;
+        return false;
+    }
+
+    qint64 fileSize = m_file.size();
+    const uchar *data = fileSize >= qint64(sizeof(Header)) ? m_file.map(0, fileSize) : nullptr;
+    if (!data) {
+        qCWarning(avatarIndex) << "Cannot map avatar index:" << path;
+        m_file.close();
+        return false;
+    }
+
+    // Check the sizes before trusting any offset in the file
+    Header header;
+    memcpy(&header, data, sizeof(header));
+    qint64 expected = qint64(sizeof(Header)) + qint64(header.count) * qint64(sizeof(qint64))
+        + (qint64(header.count) + 1) * qint64(sizeof(quint32)) + header.poolSize;
+    const quint32 *offsets = nullptr;
+    if (memcmp(header.magic, Magic, sizeof(Magic)) == 0 && expected == fileSize) {
+        offsets = reinterpret_cast<const quint32 *>(data + sizeof(Header) + size_t(header.count) * sizeof(qint64));
+    }
+    if (!offsets || offsets[header.count] != header.poolSize) {
+        qCWarning(avatarIndex) << "Ignoring malformed avatar index:" << path;
+        m_file.unmap(const_cast<uchar *>(data));
+        m_file.close();
+        return false;
+    }
+
+    m_inode = inode;
+    m_modified = modified;
+    m_count = header.count;
+    m_ids = reinterpret_cast<const qint64 *>(data + sizeof(Header));
+    m_offsets = offsets;
+    m_pool = reinterpret_cast<const char *>(offsets + header.count + 1);
+
+    qCDebug(avatarIndex) << "Mapped avatar index with" << m_count << "entries";
+    return true;
+}
+
+void AvatarIndex::close()
+{
+    if (m_ids) {
+        m_file.unmap(reinterpret_cast<uchar *>(const_cast<qint64 *>(m_ids)) - sizeof(Header));
+    }
+    m_file.close();
+    m_count = 0;
+    m_ids = nullptr;
+    m_offsets = nullptr;
+    m_pool = nullptr;
+}
+
+QString AvatarIndex::lookup(qint64 id) const
+{
+    TRACE_SCOPE("AvatarIndex::lookup");
+    if (!m_ids) {
+        return QString();
+    }
+
+    const qint64 *end = m_ids + m_count;
+    const qint64 *found = std::lower_bound(m_ids, end, id);
+    if (found == end || *found != id) {
+        return QString();
+    }
+
+    size_t i = size_t(found - m_ids);
+    quint32 begin = m_offsets[i];
+    quint32 next = m_offsets[i + 1];
+    if (begin > next || next > m_offsets[m_count]) {
+        return QString();
+    }
+    return QString::fromUtf8(m_pool + begin, int(next - begin));
+}
+
+bool AvatarIndex::write(const QString &path, QVector<QPair<qint64, QString>> entries)
+{
+    TRACE_SCOPE("AvatarIndex::write");
+
+    // Stable, so the last of several entries for one id ends up last
+    std::stable_sort(entries.begin(), entries.end(),
+                     [](const QPair<qint64, QString> &a, const QPair<qint64, QString> &b) {
+                         return a.first < b.first;
+                     });
+
+    QVector<qint64> ids;
+    QVector<quint32> offsets;
+    QByteArray pool;
+    ids.reserve(entries.size());
+    offsets.reserve(entries.size() + 1);
+    for (int i = 0; i < entries.size(); ++i) {
+        const QPair<qint64, QString> &entry = entries.at(i);
+        if (i + 1 < entries.size() && entries.at(i + 1).first == entry.first) {
+            continue;
+        }
+        if (entry.second.isEmpty()) {
+            continue;
+        }
+        ids.append(entry.first);
+        offsets.append(quint32(pool.size()));
+        pool.append(entry.second.toUtf8());
+    }
+    offsets.append(quint32(pool.size()));
+
+    Header header;
+    memcpy(header.magic, Magic, sizeof(Magic));
+    header.count = quint32(ids.size());
+    header.poolSize = quint32(pool.size());
+    header.reserved = 0;
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(avatarIndex) << "Cannot write avatar index:" << path;
+        return false;
+    }
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(ids.constData()), ids.size() * qint64(sizeof(qint64)));
+    file.write(reinterpret_cast<const char *>(offsets.constData()), offsets.size() * qint64(sizeof(quint32)));
+    file.write(pool);
+    if (!file.commit()) {
+        qCWarning(avatarIndex) << "Cannot write avatar index:" << path << file.errorString();
+        return false;
+    }
+
+    qCDebug(avatarIndex) << "Wrote avatar index with" << ids.size() << "entries";
+    return true;
+}
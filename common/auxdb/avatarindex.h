@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * AvatarIndex - Read-only memory-mapped chat id to avatar path index
+ */
+
+#pragma once
+
+#include <QFile>
+#include <QPair>
+#include <QString>
+#include <QVector>
+
+// A snapshot of the avatar paths in chatlist_map that can be searched
+// without SQLite. It is rewritten when a transaction that changed an
+// avatar commits; the file is replaced by rename, so a reader never sees a
+// partial index and keeps its old mapping until it opens the new one.
+//
+// Layout, in host byte order:
+//   header   magic "AVX1", entry count, string pool size, reserved
+//   ids      qint64[count], sorted ascending
+//   offsets  quint32[count + 1] into the pool
+//   pool     UTF-8 paths, not terminated
+class AvatarIndex
+{
+public:
+    AvatarIndex();
+    ~AvatarIndex();
+
+    static QString pathIn(const QString &databaseDirectory);
+
+    // Maps the index at path. Cheap when the file is already mapped and
+    // has not been replaced since; returns false if there is no usable index.
+    bool open(const QString &path);
+    void close();
+    bool isOpen() const { return m_ids != nullptr; }
+    int size() const { return int(m_count); }
+
+    // Empty if the chat has no avatar
+    QString lookup(qint64 id) const;
+
+    // Atomically replaces the index at path with entries; empty paths are
+    // left out and the last entry wins for duplicate ids
+    static bool write(const QString &path, QVector<QPair<qint64, QString>> entries);
+
+private:
+    Q_DISABLE_COPY(AvatarIndex)
+
+    QFile m_file;
+    quint64 m_inode;
+    qint64 m_modified;
+    quint32 m_count;
+    const qint64 *m_ids;
+    const quint32 *m_offsets;
+    const char *m_pool;
+};
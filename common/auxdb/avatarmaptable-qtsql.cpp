@@ -0,0 +1,212 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * AvatarMapTable implementation on Qt SQL
+ */
+
+#include "avatarmaptable.h"
+#include "auxdatabase.h"
+#include "auxdb-sql.h"
+#include "avatarindex.h"
+#include "trace.h"
+
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QDebug>
+#include <QLoggingCategory>
+
+Q_LOGGING_CATEGORY(avatarMapTable, "avatarMapTable")
+
+AvatarMapTable::AvatarMapTable(AuxDatabase *auxdb, QObject *parent)
+    : QObject(parent)
+    , m_db(auxdb)
+{
+    qCDebug(avatarMapTable) << "AvatarMapTable initialized";
+}
+
+QString AvatarMapTable::getAvatarPathbyId(qint64 id)
+{
+    TRACE_SCOPE("AvatarMapTable::getAvatarPathbyId");
+    QString path = "";
+    QSqlQuery *query = m_db->preparedQuery(AuxDbSql::SELECT_AVATAR);
+    if (!query) {
+        return path;
+    }
+    
+    query->bindValue(":id", id);
+    
+    if (!query->exec()) {
+        m_db->logSqlError(*query);
+        return path;
+    }
+    
+    if (query->next()) {
+        path = query->value(0).toString();
+    }
+    query->finish();
+    
+    qCDebug(avatarMapTable) << "Avatar path for chat" << id << ":" << path;
+    return path;
+}
+
+void AvatarMapTable::setAvatarMapEntry(const qint64 id, const QString &path)
+{
+    TRACE_SCOPE("AvatarMapTable::setAvatarMapEntry");
+    QSqlQuery *query = m_db->preparedQuery(AuxDbSql::UPSERT_AVATAR);
+    if (!query || !m_db->transaction()) {
+        return;
+    }
+    
+    query->bindValue(":id", id);
+    query->bindValue(":path", path);
+    
+    if (!query->exec()) {
+        m_db->logSqlError(*query);
+    } else {
+        qCDebug(avatarMapTable) << "Set avatar for chat" << id << "to" << path;
+        m_db->avatarsChanged();
+    }
+    m_db->commit();
+}
+
+void AvatarMapTable::setAvatarMapEntries(const QVector<QPair<qint64, QString>> &entries)
+{
+    TRACE_SCOPE("AvatarMapTable::setAvatarMapEntries");
+    QSqlQuery *query = m_db->preparedQuery(AuxDbSql::UPSERT_AVATAR);
+    if (!query || !m_db->transaction()) {
+        return;
+    }
+    
+    for (const auto &entry : entries) {
+        query->bindValue(":id", entry.first);
+        query->bindValue(":path", entry.second);
+        if (!query->exec()) {
+            m_db->logSqlError(*query);
+        }
+    }
+    
+    m_db->avatarsChanged();
+    m_db->commit();
+    qCDebug(avatarMapTable) << "Set avatars for" << entries.size() << "chats";
+}
+
+bool AvatarMapTable::rebuildAvatarIndex()
+{
+    TRACE_SCOPE("AvatarMapTable::rebuildAvatarIndex");
+    QSqlQuery *query = m_db->preparedQuery(AuxDbSql::SELECT_AVATARS);
+    if (!query) {
+        return false;
+    }
+    
+    if (!query->exec()) {
+        m_db->logSqlError(*query);
+        return false;
+    }
+    
+    QVector<QPair<qint64, QString>> entries;
+    while (query->next()) {
+        entries.append(qMakePair(query->value(0).toLongLong(), query->value(1).toString()));
+    }
+    query->finish();
+    
+    return AvatarIndex::write(m_db->avatarIndexPath(), entries);
+}
+
+void AvatarMapTable::setUnreadMapEntry(const qint64 id, const qint32 unread_messages)
+{
+    TRACE_SCOPE("AvatarMapTable::setUnreadMapEntry");
+    QSqlQuery *query = m_db->preparedQuery(AuxDbSql::UPSERT_UNREAD);
+    if (!query) {
+        return;
+    }
+    
+    query->bindValue(":id", id);
+    query->bindValue(":unread_messages", unread_messages);
+    
+    if (!query->exec()) {
+        m_db->logSqlError(*query);
+    } else {
+        qCDebug(avatarMapTable) << "Set unread count for chat" << id << "to" << unread_messages;
+    }
+}
+
+void AvatarMapTable::setUnreadMapEntries(const QVector<QPair<qint64, qint32>> &entries)
+{
+    TRACE_SCOPE("AvatarMapTable::setUnreadMapEntries");
+    QSqlQuery *query = m_db->preparedQuery(AuxDbSql::UPSERT_UNREAD);
+    if (!query || !m_db->transaction()) {
+        return;
+    }
+    
+    for (const auto &entry : entries) {
+        query->bindValue(":id", entry.first);
+        query->bindValue(":unread_messages", entry.second);
+        if (!query->exec()) {
+            m_db->logSqlError(*query);
+        }
+    }
+    
+    m_db->commit();
+    qCDebug(avatarMapTable) << "Set unread counts for" << entries.size() << "chats";
+}
+
+qint32 AvatarMapTable::getUnreadCount(qint64 id)
+{
+    TRACE_SCOPE("AvatarMapTable::getUnreadCount");
+    qint32 count = 0;
+    QSqlQuery *query = m_db->preparedQuery(AuxDbSql::SELECT_UNREAD);
+    if (!query) {
+        return count;
+    }
+    
+    query->bindValue(":id", id);
+    
+    if (!query->exec()) {
+        m_db->logSqlError(*query);
+        return count;
+    }
+    
+    if (query->next()) {
+        count = query->value(0).toInt();
+    }
+    query->finish();
+    
+    return count;
+}
+
+qint32 AvatarMapTable::getTotalUnread()
+{
+    TRACE_SCOPE("AvatarMapTable::getTotalUnread");
+    qint32 totalCount = 0;
+    QSqlQuery *query = m_db->preparedQuery(AuxDbSql::SELECT_TOTAL_UNREAD);
+    if (!query) {
+        return totalCount;
+    }
+    
+    if (!query->exec()) {
+        m_db->logSqlError(*query);
+        return totalCount;
+    }
+    
+    if (query->next()) {
+        totalCount = query->value(0).toInt();
+    }
+    query->finish();
+    
+    qCDebug(avatarMapTable) << "Total unread count:" << totalCount;
+    return totalCount;
+}
+
+void AvatarMapTable::resetUnreadMap()
+{
+    QSqlQuery *query = m_db->preparedQuery(AuxDbSql::RESET_UNREAD);
+    if (!query) {
+        return;
+    }
+    
+    if (!query->exec()) {
+        m_db->logSqlError(*query);
+    } else {
+        qCDebug(avatarMapTable) << "Reset all unread counts";
+    }
+}
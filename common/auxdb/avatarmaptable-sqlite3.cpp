@@ -0,0 +1,223 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * AvatarMapTable implementation on libsqlite3
+ *
+ * Parameters are bound by position in the order they first appear in the
+ * AuxDbSql text: :id is always 1.
+ */
+
+#include "avatarmaptable.h"
+#include "auxdatabase.h"
+#include "auxdb-sql.h"
+#include "avatarindex.h"
+#include "trace.h"
+
+#include <QDebug>
+#include <QLoggingCategory>
+
+#include <sqlite3.h>
+
+Q_LOGGING_CATEGORY(avatarMapTable, "avatarMapTable")
+
+namespace {
+
+// Steps a statement that returns no rows and resets it for the next use
+bool stepDone(AuxDatabase *db, sqlite3_stmt *statement, const char *sql)
+{
+    bool ok = sqlite3_step(statement) == SQLITE_DONE;
+    if (!ok) {
+        db->logSqliteError(sql);
+    }
+    sqlite3_reset(statement);
+    return ok;
+}
+
+// Steps a single-column, at most single-row query and resets it
+qint32 stepInt(AuxDatabase *db, sqlite3_stmt *statement, const char *sql)
+{
+    qint32 value = 0;
+    int rc = sqlite3_step(statement);
+    if (rc == SQLITE_ROW) {
+        value = sqlite3_column_int(statement, 0);
+    } else if (rc != SQLITE_DONE) {
+        db->logSqliteError(sql);
+    }
+    sqlite3_reset(statement);
+    return value;
+}
+
+void bindText(sqlite3_stmt *statement, int index, const QByteArray &utf8)
+{
+    // The caller keeps utf8 alive until the statement has been stepped
+    sqlite3_bind_text(statement, index, utf8.constData(), utf8.size(), SQLITE_STATIC);
+}
+
+} // namespace
+
+AvatarMapTable::AvatarMapTable(AuxDatabase *auxdb, QObject *parent)
+    : QObject(parent)
+    , m_db(auxdb)
+{
+    qCDebug(avatarMapTable) << "AvatarMapTable initialized";
+}
+
+QString AvatarMapTable::getAvatarPathbyId(qint64 id)
+{
+    TRACE_SCOPE("AvatarMapTable::getAvatarPathbyId");
+    QString path = "";
+    sqlite3_stmt *statement = m_db->preparedStatement(AuxDbSql::SELECT_AVATAR);
+    if (!statement) {
+        return path;
+    }
+    
+    sqlite3_bind_int64(statement, 1, id);
+    
+    int rc = sqlite3_step(statement);
+    if (rc == SQLITE_ROW) {
+        path = QString::fromUtf8(reinterpret_cast<const char *>(sqlite3_column_text(statement, 0)),
+                                 sqlite3_column_bytes(statement, 0));
+    } else if (rc != SQLITE_DONE) {
+        m_db->logSqliteError(AuxDbSql::SELECT_AVATAR);
+    }
+    sqlite3_reset(statement);
+    
+    qCDebug(avatarMapTable) << "Avatar path for chat" << id << ":" << path;
+    return path;
+}
+
+void AvatarMapTable::setAvatarMapEntry(const qint64 id, const QString &path)
+{
+    TRACE_SCOPE("AvatarMapTable::setAvatarMapEntry");
+    sqlite3_stmt *statement = m_db->preparedStatement(AuxDbSql::UPSERT_AVATAR);
+    if (!statement || !m_db->transaction()) {
+        return;
+    }
+    
+    QByteArray utf8 = path.toUtf8();
+    sqlite3_bind_int64(statement, 1, id);
+    bindText(statement, 2, utf8);
+    
+    if (stepDone(m_db, statement, AuxDbSql::UPSERT_AVATAR)) {
+        qCDebug(avatarMapTable) << "Set avatar for chat" << id << "to" << path;
+        m_db->avatarsChanged();
+    }
+    m_db->commit();
+}
+
+void AvatarMapTable::setAvatarMapEntries(const QVector<QPair<qint64, QString>> &entries)
+{
+    TRACE_SCOPE("AvatarMapTable::setAvatarMapEntries");
+    sqlite3_stmt *statement = m_db->preparedStatement(AuxDbSql::UPSERT_AVATAR);
+    if (!statement || !m_db->transaction()) {
+        return;
+    }
+    
+    for (const auto &entry : entries) {
+        QByteArray utf8 = entry.second.toUtf8();
+        sqlite3_bind_int64(statement, 1, entry.first);
+        bindText(statement, 2, utf8);
+        stepDone(m_db, statement, AuxDbSql::UPSERT_AVATAR);
+    }
+    
+    m_db->avatarsChanged();
+    m_db->commit();
+    qCDebug(avatarMapTable) << "Set avatars for" << entries.size() << "chats";
+}
+
+bool AvatarMapTable::rebuildAvatarIndex()
+{
+    TRACE_SCOPE("AvatarMapTable::rebuildAvatarIndex");
+    sqlite3_stmt *statement = m_db->preparedStatement(AuxDbSql::SELECT_AVATARS);
+    if (!statement) {
+        return false;
+    }
+    
+    QVector<QPair<qint64, QString>> entries;
+    int rc;
+    while ((rc = sqlite3_step(statement)) == SQLITE_ROW) {
+        entries.append(qMakePair(qint64(sqlite3_column_int64(statement, 0)),
+                                 QString::fromUtf8(reinterpret_cast<const char *>(sqlite3_column_text(statement, 1)),
+                                                   sqlite3_column_bytes(statement, 1))));
+    }
+    if (rc != SQLITE_DONE) {
+        m_db->logSqliteError(AuxDbSql::SELECT_AVATARS);
+    }
+    sqlite3_reset(statement);
+    if (rc != SQLITE_DONE) {
+        return false;
+    }
+    
+    return AvatarIndex::write(m_db->avatarIndexPath(), entries);
+}
+
+void AvatarMapTable::setUnreadMapEntry(const qint64 id, const qint32 unread_messages)
+{
+    TRACE_SCOPE("AvatarMapTable::setUnreadMapEntry");
+    sqlite3_stmt *statement = m_db->preparedStatement(AuxDbSql::UPSERT_UNREAD);
+    if (!statement) {
+        return;
+    }
+    
+    sqlite3_bind_int64(statement, 1, id);
+    sqlite3_bind_int(statement, 2, unread_messages);
+    
+    if (stepDone(m_db, statement, AuxDbSql::UPSERT_UNREAD)) {
+        qCDebug(avatarMapTable) << "Set unread count for chat" << id << "to" << unread_messages;
+    }
+}
+
+void AvatarMapTable::setUnreadMapEntries(const QVector<QPair<qint64, qint32>> &entries)
+{
+    TRACE_SCOPE("AvatarMapTable::setUnreadMapEntries");
+    sqlite3_stmt *statement = m_db->preparedStatement(AuxDbSql::UPSERT_UNREAD);
+    if (!statement || !m_db->transaction()) {
+        return;
+    }
+    
+    for (const auto &entry : entries) {
+        sqlite3_bind_int64(statement, 1, entry.first);
+        sqlite3_bind_int(statement, 2, entry.second);
+        stepDone(m_db, statement, AuxDbSql::UPSERT_UNREAD);
+    }
+    
+    m_db->commit();
+    qCDebug(avatarMapTable) << "Set unread counts for" << entries.size() << "chats";
+}
+
+qint32 AvatarMapTable::getUnreadCount(qint64 id)
+{
+    TRACE_SCOPE("AvatarMapTable::getUnreadCount");
+    sqlite3_stmt *statement = m_db->preparedStatement(AuxDbSql::SELECT_UNREAD);
+    if (!statement) {
+        return 0;
+    }
+    
+    sqlite3_bind_int64(statement, 1, id);
+    return stepInt(m_db, statement, AuxDbSql::SELECT_UNREAD);
+}
+
+qint32 AvatarMapTable::getTotalUnread()
+{
+    TRACE_SCOPE("AvatarMapTable::getTotalUnread");
+    sqlite3_stmt *statement = m_db->preparedStatement(AuxDbSql::SELECT_TOTAL_UNREAD);
+    if (!statement) {
+        return 0;
+    }
+    
+    qint32 totalCount = stepInt(m_db, statement, AuxDbSql::SELECT_TOTAL_UNREAD);
+    qCDebug(avatarMapTable) << "Total unread count:" << totalCount;
+    return totalCount;
+}
+
+void AvatarMapTable::resetUnreadMap()
+{
+    sqlite3_stmt *statement = m_db->preparedStatement(AuxDbSql::RESET_UNREAD);
+    if (!statement) {
+        return;
+    }
+    
+    if (stepDone(m_db, statement, AuxDbSql::RESET_UNREAD)) {
+        qCDebug(avatarMapTable) << "Reset all unread counts";
+    }
+}
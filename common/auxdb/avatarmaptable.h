@@ -7,8 +7,9 @@
 #pragma once
 
 #include <QObject>
-#include <QSqlQuery>
 #include <QString>
+#include <QVector>
+#include <QPair>
 
 class AuxDatabase;
 
@@ -22,9 +23,16 @@ public:
     // Avatar management
     QString getAvatarPathbyId(qint64 id);
     void setAvatarMapEntry(const qint64 id, const QString &path);
+    void setAvatarMapEntries(const QVector<QPair<qint64, QString>> &entries);
+    
+    // Rewrites the read-only avatar index from the table. The setters
+    // above leave it to AuxDatabase::commit(), so group several changes
+    // in one transaction to rewrite it once.
+    bool rebuildAvatarIndex();
     
     // Unread count management
     void setUnreadMapEntry(const qint64 id, const qint32 unread_messages);
+    void setUnreadMapEntries(const QVector<QPair<qint64, qint32>> &entries);
     qint32 getUnreadCount(qint64 id);
     qint32 getTotalUnread();
     void resetUnreadMap();
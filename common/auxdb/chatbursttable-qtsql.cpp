@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * ChatBurstTable storage on Qt SQL
+ */
+
+#include "chatbursttable.h"
+#include "auxdatabase.h"
+#include "auxdb-sql.h"
+
+#include <QSqlQuery>
+#include <QVariant>
+
+bool ChatBurstTable::load(qint64 id, qint64 &started, int &count, QString &lines)
+{
+    QSqlQuery *query = m_db->preparedQuery(AuxDbSql::SELECT_CHAT_BURST);
+    if (!query) {
+        return false;
+    }
+    
+    query->bindValue(":id", id);
+    if (!query->exec()) {
+        m_db->logSqlError(*query);
+        return false;
+    }
+    
+    bool found = query->next();
+    if (found) {
+        started = query->value(0).toLongLong();
+        count = query->value(1).toInt();
+        lines = query->value(2).toString();
+    }
+    query->finish();
+    return found;
+}
+
+bool ChatBurstTable::store(qint64 id, qint64 started, int count, const QString &lines)
+{
+    QSqlQuery *query = m_db->preparedQuery(AuxDbSql::UPSERT_CHAT_BURST);
+    if (!query) {
+        return false;
+    }
+    
+    query->bindValue(":id", id);
+    query->bindValue(":started", started);
+    query->bindValue(":count", count);
+    query->bindValue(":lines", lines);
+    
+    if (!query->exec()) {
+        m_db->logSqlError(*query);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * ChatBurstTable storage on libsqlite3
+ *
+ * Parameters are bound by position in the order they first appear in the
+ * AuxDbSql text.
+ */
+
+#include "chatbursttable.h"
+#include "auxdatabase.h"
+#include "auxdb-sql.h"
+
+#include <sqlite3.h>
+
+bool ChatBurstTable::load(qint64 id, qint64 &started, int &count, QString &lines)
+{
+    sqlite3_stmt *statement = m_db->preparedStatement(AuxDbSql::SELECT_CHAT_BURST);
+    if (!statement) {
+        return false;
+    }
+    
+    sqlite3_bind_int64(statement, 1, id);
+    
+    int rc = sqlite3_step(statement);
+    if (rc == SQLITE_ROW) {
+        started = sqlite3_column_int64(statement, 0);
+        count = sqlite3_column_int(statement, 1);
+        lines = QString::fromUtf8(reinterpret_cast<const char *>(sqlite3_column_text(statement, 2)),
+                                  sqlite3_column_bytes(statement, 2));
+    } else if (rc != SQLITE_DONE) {
+        m_db->logSqliteError(AuxDbSql::SELECT_CHAT_BURST);
+    }
+    sqlite3_reset(statement);
+    return rc == SQLITE_ROW;
+}
+
+bool ChatBurstTable::store(qint64 id, qint64 started, int count, const QString &lines)
+{
+    sqlite3_stmt *statement = m_db->preparedStatement(AuxDbSql::UPSERT_CHAT_BURST);
+    if (!statement) {
+        return false;
+    }
+    
+    QByteArray utf8 = lines.toUtf8();
+    sqlite3_bind_int64(statement, 1, id);
+    sqlite3_bind_int64(statement, 2, started);
+    sqlite3_bind_int(statement, 3, count);
+    sqlite3_bind_text(statement, 4, utf8.constData(), utf8.size(), SQLITE_STATIC);
+    
+    bool ok = sqlite3_step(statement) == SQLITE_DONE;
+    if (!ok) {
+        m_db->logSqliteError(AuxDbSql::UPSERT_CHAT_BURST);
+    }
+    sqlite3_reset(statement);
+    return ok;
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * ChatBurstTable implementation
+ *
+ * One row per chat holds when its current burst started, how many
+ * messages it has seen and the latest lines joined by newlines. Rows are
+ * overwritten when a new burst starts, so the table never holds more than
+ * one row per chat.
+ */
+
+#include "chatbursttable.h"
+#include "auxdatabase.h"
+#include "trace.h"
+
+#include <QDebug>
+#include <QLoggingCategory>
+
+Q_LOGGING_CATEGORY(chatBurstTable, "chatBurstTable")
+
+// Lines are stored newline-separated, and a preview line does not need
+// more than this
+static const int MAX_LINE_LENGTH = 160;
+
+ChatBurstTable::ChatBurstTable(AuxDatabase *auxdb, QObject *parent)
+    : QObject(parent)
+    , m_db(auxdb)
+{
+    qCDebug(chatBurstTable) << "ChatBurstTable initialized";
+}
+
+ChatBurst ChatBurstTable::addMessage(qint64 id, const QString &line, qint64 nowMs, qint64 windowMs, int maxLines,
+                                     bool fresh)
+{
+    TRACE_SCOPE("ChatBurstTable::addMessage");
+    ChatBurst burst;
+    QString cleanLine = line.left(MAX_LINE_LENGTH).simplified();
+    
+    // Other helpers may add to the same chat concurrently; read and write
+    // the row under one write lock
+    m_db->transaction();
+    
+    qint64 started = 0;
+    int count = 0;
+    QString lines;
+    if (!fresh && load(id, started, count, lines) && nowMs >= started && nowMs - started < windowMs) {
+        burst.count = count + 1;
+        burst.lines = lines.split('\n', QString::SkipEmptyParts);
+    } else {
+        started = nowMs;
+        burst.count = 1;
+    }
+    
+    burst.lines.append(cleanLine);
+    while (burst.lines.size() > maxLines) {
+        burst.lines.removeFirst();
+    }
+    
+    store(id, started, burst.count, burst.lines.join('\n'));
+    m_db->commit();
+    
+    qCDebug(chatBurstTable) << "Chat" << id << "has" << burst.count << "messages in its burst";
+    return burst;
+}
@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * ChatBurstTable - Recent messages per chat, for coalescing notifications
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+class AuxDatabase;
+
+// The messages of one chat that arrived within a coalescing window
+struct ChatBurst
+{
+    // Messages in the window, including the one just added; 1 means the
+    // message opened a new window
+    int count = 0;
+
+    // The latest message lines, oldest first
+    QStringList lines;
+};
+
+class ChatBurstTable : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ChatBurstTable(AuxDatabase *auxdb, QObject *parent = nullptr);
+    
+    // Adds a message line to the burst of chat id at nowMs and returns the
+    // burst. A burst lasts windowMs from its first message; a message after
+    // that, or one with fresh set because the user has read the chat since,
+    // starts a new one. Only the latest maxLines lines are kept.
+    ChatBurst addMessage(qint64 id, const QString &line, qint64 nowMs, qint64 windowMs, int maxLines,
+                         bool fresh = false);
+
+private:
+    // Backend primitives, see chatbursttable-qtsql.cpp and chatbursttable-sqlite3.cpp
+    bool load(qint64 id, qint64 &started, int &count, QString &lines);
+    bool store(qint64 id, qint64 started, int count, const QString &lines);
+    
+    AuxDatabase *m_db;
+};
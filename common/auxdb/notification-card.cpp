@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * NotificationCard implementation
+ *
+ * A small streaming JSON writer: strings are escaped and UTF-8 encoded
+ * straight from QString into the output buffer, with no intermediate
+ * QJsonObject tree or QByteArray conversions.
+ */
+
+#include "notification-card.h"
+#include "trace.h"
+
+namespace {
+
+void appendString(QByteArray &out, const QString &value)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    out.append('"');
+    const QChar *chars = value.constData();
+    const int size = value.size();
+    for (int i = 0; i < size; ++i) {
+        uint code = chars[i].unicode();
+
+        if (code == '"' || code == '\\') {
+            out.append('\\');
+            out.append(char(code));
+        } else if (code < 0x20) {
+            switch (code) {
+            case '\n': out.append("\\n", 2); break;
+            case '\r': out.append("\\r", 2); break;
+            case '\t': out.append("\\t", 2); break;
+            default: {
+                char escape[6] = { '\\', 'u', '0', '0', hex[code >> 4], hex[code & 0xf] };
+                out.append(escape, 6);
+            }
+            }
+        } else if (code < 0x80) {
+            out.append(char(code));
+        } else if (code < 0x800) {
+            out.append(char(0xc0 | (code >> 6)));
+            out.append(char(0x80 | (code & 0x3f)));
+        } else {
+            if (QChar::isHighSurrogate(code) && i + 1 < size && chars[i + 1].isLowSurrogate()) {
+                code = QChar::surrogateToUcs4(ushort(code), chars[++i].unicode());
+                out.append(char(0xf0 | (code >> 18)));
+                out.append(char(0x80 | ((code >> 12) & 0x3f)));
+            } else {
+                if (QChar::isSurrogate(code)) {
+                    code = QChar::ReplacementCharacter;
+                }
+                out.append(char(0xe0 | (code >> 12)));
+            }
+            out.append(char(0x80 | ((code >> 6) & 0x3f)));
+            out.append(char(0x80 | (code & 0x3f)));
+        }
+    }
+    out.append('"');
+}
+
+void appendBool(QByteArray &out, const char *key, bool value)
+{
+    out.append(key);
+    out.append(value ? "true" : "false");
+}
+
+} // namespace
+
+void NotificationCard::serialize(QByteArray &out) const
+{
+    TRACE_SCOPE("NotificationCard::serialize");
+
+    // reserve() marks the capacity as reserved, which makes resize(0)
+    // keep the allocation instead of freeing it
+    int estimate = 192 + 3 * (summary.size() + body.size() + icon.size() + tag.size());
+    for (const QString &action : actions) {
+        estimate += 3 * action.size() + 3;
+    }
+    if (out.capacity() < estimate) {
+        out.reserve(estimate);
+    }
+    out.resize(0);
+
+    out.append("{\"notification\":{\"card\":{\"summary\":");
+    appendString(out, summary);
+    out.append(",\"body\":");
+    appendString(out, body);
+    out.append(",\"icon\":");
+    appendString(out, icon.isEmpty() ? QStringLiteral("notification") : icon);
+    appendBool(out, ",\"persist\":", persist);
+    appendBool(out, ",\"popup\":", popup);
+
+    // Actions make the notification clickable
+    if (!actions.isEmpty()) {
+        out.append(",\"actions\":[");
+        for (int i = 0; i < actions.size(); ++i) {
+            if (i > 0) {
+                out.append(',');
+            }
+            appendString(out, actions.at(i));
+        }
+        out.append(']');
+    }
+
+    out.append("},\"tag\":");
+    appendString(out, tag);
+    appendBool(out, ",\"vibrate\":", vibrate);
+    appendBool(out, ",\"sound\":", sound);
+
+    if (emblemCount > 0) {
+        out.append(",\"emblem-counter\":{\"count\":");
+        char digits[16];
+        out.append(digits, qsnprintf(digits, sizeof(digits), "%d", emblemCount));
+        out.append(",\"visible\":true}");
+    }
+
+    out.append("}}");
+}
@@ -0,0 +1,32 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * NotificationCard - The notification we show for a push, in the format
+ * shared by the push helper outfile and the Postal Post call
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+
+struct NotificationCard
+{
+    QString summary;
+    QString body;
+    QString icon;
+    QString tag;
+    QStringList actions;
+    bool popup = true;
+    bool persist = true;
+    bool sound = true;
+    bool vibrate = true;
+
+    // The emblem-counter object is only written when this is positive
+    int emblemCount = 0;
+
+    // Writes the {"notification": ...} JSON into out. out is overwritten
+    // but keeps its capacity, so a reused buffer does not reallocate.
+    void serialize(QByteArray &out) const;
+};
@@ -13,29 +13,32 @@
 #include <QDebug>
 #include <QLoggingCategory>
 
+#include "trace.h"
+
 Q_LOGGING_CATEGORY(notificationClient, "notificationClient")
 
 NotificationClient::NotificationClient(QString appId, QObject *parent)
-    : QObject(parent), m_appId(appId), m_lastNotificationId(0)
+    : QObject(parent), m_appId(appId), m_lastNotificationId(0), m_tracker(nullptr)
 {
-    qDebug(notificationClient) << "NotificationClient initialized for app:" << m_appId;
+    qCDebug(notificationClient) << "NotificationClient initialized for app:" << m_appId;
 }
 
 void NotificationClient::notify(const QString &summary, const QString &body,
                                const QString &icon, const QStringList &actions,
                                const QVariantMap &hints, int timeout)
 {
+    TRACE_SCOPE("NotificationClient::notify");
     QDBusConnection bus = QDBusConnection::sessionBus();
     if (!bus.isConnected())
     {
-        qWarning(notificationClient) << "D-Bus session bus not connected";
+        qCWarning(notificationClient) << "D-Bus session bus not connected";
         return;
     }
 
-    qDebug(notificationClient) << "Sending notification:";
-    qDebug(notificationClient) << "  Summary:" << summary;
-    qDebug(notificationClient) << "  Body:" << body;
-    qDebug(notificationClient) << "  Icon:" << icon;
+    qCDebug(notificationClient) << "Sending notification:";
+    qCDebug(notificationClient) << "  Summary:" << summary;
+    qCDebug(notificationClient) << "  Body:" << body;
+    qCDebug(notificationClient) << "  Icon:" << icon;
 
     // Create the D-Bus method call
     QDBusMessage message = QDBusMessage::createMethodCall(
@@ -70,6 +73,10 @@ void NotificationClient::notify(const QString &summary, const QString &body,
     QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(pcall, this);
     connect(watcher, &QDBusPendingCallWatcher::finished,
             this, &NotificationClient::notifyFinished);
+    if (m_tracker)
+    {
+        m_tracker->track(watcher, "Notify");
+    }
 }
 
 void NotificationClient::notifyFinished(QDBusPendingCallWatcher *watcher)
@@ -77,12 +84,12 @@ void NotificationClient::notifyFinished(QDBusPendingCallWatcher *watcher)
     QDBusPendingReply<uint> reply = *watcher;
     if (reply.isError())
     {
-        qWarning(notificationClient) << "Notify D-Bus call failed:" << reply.error().message();
+        qCWarning(notificationClient) << "Notify D-Bus call failed:" << reply.error().message();
     }
     else
     {
         m_lastNotificationId = reply.value();
-        qDebug(notificationClient) << "Notification sent successfully, ID:" << m_lastNotificationId;
+        qCDebug(notificationClient) << "Notification sent successfully, ID:" << m_lastNotificationId;
     }
     watcher->deleteLater();
 }
@@ -15,6 +15,8 @@
 #include <QStringList>
 #include <QVariantMap>
 
+#include "pending-call-tracker.h"
+
 #define NOTIFICATION_SERVICE "org.freedesktop.Notifications"
 #define NOTIFICATION_PATH "/org/freedesktop/Notifications"
 #define NOTIFICATION_IFACE "org.freedesktop.Notifications"
@@ -26,6 +28,9 @@ class NotificationClient : public QObject
 public:
     explicit NotificationClient(QString appId, QObject *parent = nullptr);
 
+    // Report every call to tracker so callers can wait for completion
+    void setCallTracker(PendingCallTracker *tracker) { m_tracker = tracker; }
+
     // Send a notification to the notification panel
     void notify(const QString &summary, const QString &body, 
                 const QString &icon = "notification", 
@@ -39,4 +44,5 @@ private Q_SLOTS:
 private:
     QString m_appId;
     uint m_lastNotificationId;
+    PendingCallTracker *m_tracker;
 };
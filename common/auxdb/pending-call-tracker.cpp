@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * PendingCallTracker implementation
+ */
+
+#include "pending-call-tracker.h"
+#include "trace.h"
+
+#include <QDebug>
+#include <QLoggingCategory>
+
+Q_LOGGING_CATEGORY(pendingCallTracker, "pendingCallTracker")
+
+PendingCallTracker::PendingCallTracker(int deadlineMs, QObject *parent)
+    : QObject(parent), m_deadlineMs(deadlineMs)
+{
+    m_clock.start();
+    m_expiryTimer.setSingleShot(true);
+    connect(&m_expiryTimer, &QTimer::timeout, this, &PendingCallTracker::expireCalls);
+}
+
+void PendingCallTracker::track(QDBusPendingCallWatcher *watcher, const char *name)
+{
+    qint64 deadline = m_clock.elapsed() + m_deadlineMs;
+    m_pending.insert(watcher, { name, deadline, Trace::enabled() ? Trace::now() : -1 });
+
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, &PendingCallTracker::callFinished);
+    connect(watcher, &QObject::destroyed, this, &PendingCallTracker::callFinished);
+
+    qCDebug(pendingCallTracker) << "Tracking" << name << "-" << m_pending.size() << "calls pending";
+
+    if (!m_expiryTimer.isActive())
+    {
+        scheduleExpiry();
+    }
+}
+
+QStringList PendingCallTracker::takeTimedOut()
+{
+    QStringList timedOut = m_timedOut;
+    m_timedOut.clear();
+    return timedOut;
+}
+
+void PendingCallTracker::callFinished()
+{
+    remove(sender(), true);
+}
+
+void PendingCallTracker::expireCalls()
+{
+    qint64 now = m_clock.elapsed();
+    QList<QObject *> expired;
+    for (auto it = m_pending.constBegin(); it != m_pending.constEnd(); ++it)
+    {
+        if (it.value().deadline <= now)
+        {
+            expired.append(it.key());
+        }
+    }
+
+    for (QObject *watcher : expired)
+    {
+        const char *name = m_pending.value(watcher).name;
+        qCWarning(pendingCallTracker) << "D-Bus call timed out:" << name;
+        m_timedOut.append(QString::fromLatin1(name));
+
+        // The watcher stays with its owner; we just stop waiting for it
+        disconnect(watcher, nullptr, this, nullptr);
+        remove(watcher, false);
+    }
+
+    scheduleExpiry();
+}
+
+void PendingCallTracker::remove(QObject *watcher, bool answered)
+{
+    auto it = m_pending.find(watcher);
+    if (it == m_pending.end())
+    {
+        return;
+    }
+
+    // Round trip from the call going out to its reply arriving
+    if (answered && it.value().traceStart >= 0)
+    {
+        Trace::complete("dbus", it.value().name, it.value().traceStart, Trace::now());
+    }
+    m_pending.erase(it);
+
+    if (m_pending.isEmpty())
+    {
+        m_expiryTimer.stop();
+        qCDebug(pendingCallTracker) << "All D-Bus calls completed";
+        Q_EMIT idle();
+    }
+}
+
+void PendingCallTracker::scheduleExpiry()
+{
+    if (m_pending.isEmpty())
+    {
+        return;
+    }
+
+    qint64 next = std::numeric_limits<qint64>::max();
+    for (const PendingCall &call : m_pending)
+    {
+        next = qMin(next, call.deadline);
+    }
+    m_expiryTimer.start(int(qMax<qint64>(0, next - m_clock.elapsed())));
+}
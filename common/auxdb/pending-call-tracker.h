@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * PendingCallTracker - Keeps track of in-flight D-Bus calls so the push
+ * helper can exit as soon as they have all been answered
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QDBusPendingCallWatcher>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+
+#include <limits>
+
+class PendingCallTracker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PendingCallTracker(int deadlineMs = 1000, QObject *parent = nullptr);
+
+    // Tracks watcher until it finishes or its deadline expires; name is
+    // kept by pointer for tracing, so pass the method name as a literal
+    void track(QDBusPendingCallWatcher *watcher, const char *name);
+
+    int pendingCount() const { return m_pending.size(); }
+
+    // Names of calls whose deadline expired since the last call
+    QStringList takeTimedOut();
+
+Q_SIGNALS:
+    // Emitted whenever the last pending call finishes or expires
+    void idle();
+
+private Q_SLOTS:
+    void callFinished();
+    void expireCalls();
+
+private:
+    struct PendingCall
+    {
+        const char *name;
+        qint64 deadline;
+        qint64 traceStart;
+    };
+
+    void remove(QObject *watcher, bool answered);
+    void scheduleExpiry();
+
+    int m_deadlineMs;
+    QElapsedTimer m_clock;
+    QTimer m_expiryTimer;
+    QHash<QObject *, PendingCall> m_pending;
+    QStringList m_timedOut;
+};
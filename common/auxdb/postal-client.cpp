@@ -12,14 +12,14 @@
 #include <QDBusPendingCallWatcher>
 #include <QDebug>
 #include <QLoggingCategory>
-#include <QJsonDocument>
-#include <QJsonObject>
-#include <QJsonArray>
+
+#include "notification-card.h"
+#include "trace.h"
 
 Q_LOGGING_CATEGORY(postalClient, "postalClient")
 
 PostalClient::PostalClient(QString appId, QObject *parent)
-    : QObject(parent), m_appId(appId)
+    : QObject(parent), m_appId(appId), m_tracker(nullptr)
 {
     // Extract package name from app ID
     this->m_pkgName = appId.split("_").at(0);
@@ -27,16 +27,17 @@ PostalClient::PostalClient(QString appId, QObject *parent)
     // Escape special characters for D-Bus path
     this->m_pkgName = m_pkgName.replace(".", "_2e").replace("-", "_2d");
 
-    qDebug(postalClient) << "PostalClient initialized for app:" << m_appId;
-    qDebug(postalClient) << "Package name:" << m_pkgName;
+    qCDebug(postalClient) << "PostalClient initialized for app:" << m_appId;
+    qCDebug(postalClient) << "Package name:" << m_pkgName;
 }
 
 void PostalClient::setCount(int count)
 {
+    TRACE_SCOPE("PostalClient::setCount");
     QDBusConnection bus = QDBusConnection::sessionBus();
     if (!bus.isConnected())
     {
-        qWarning(postalClient) << "D-Bus session bus not connected";
+        qCWarning(postalClient) << "D-Bus session bus not connected";
         return;
     }
 
@@ -44,8 +45,8 @@ void PostalClient::setCount(int count)
     bool visible = count != 0;
     path += "/" + m_pkgName;
 
-    qDebug(postalClient) << "Setting badge count:" << count << "visible:" << visible;
-    qDebug(postalClient) << "D-Bus path:" << path;
+    qCDebug(postalClient) << "Setting badge count:" << count << "visible:" << visible;
+    qCDebug(postalClient) << "D-Bus path:" << path;
 
     QDBusMessage message = QDBusMessage::createMethodCall(
         POSTAL_SERVICE, path, POSTAL_IFACE, "SetCounter");
@@ -55,6 +56,10 @@ void PostalClient::setCount(int count)
     QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(pcall, this);
     connect(watcher, SIGNAL(finished(QDBusPendingCallWatcher *)),
             this, SLOT(setCountFinished(QDBusPendingCallWatcher *)));
+    if (m_tracker)
+    {
+        m_tracker->track(watcher, "SetCounter");
+    }
 }
 
 void PostalClient::setCountFinished(QDBusPendingCallWatcher *watcher)
@@ -62,29 +67,30 @@ void PostalClient::setCountFinished(QDBusPendingCallWatcher *watcher)
     QDBusPendingReply<void> reply = *watcher;
     if (reply.isError())
     {
-        qWarning(postalClient) << "SetCounter D-Bus call failed:" << reply.error().message();
+        qCWarning(postalClient) << "SetCounter D-Bus call failed:" << reply.error().message();
     }
     else
     {
-        qDebug(postalClient) << "Badge count updated successfully";
+        qCDebug(postalClient) << "Badge count updated successfully";
     }
     watcher->deleteLater();
 }
 
 void PostalClient::clearPersistent(const QStringList &tags)
 {
+    TRACE_SCOPE("PostalClient::clearPersistent");
     QDBusConnection bus = QDBusConnection::sessionBus();
     if (!bus.isConnected())
     {
-        qWarning(postalClient) << "D-Bus session bus not connected";
+        qCWarning(postalClient) << "D-Bus session bus not connected";
         return;
     }
 
     QString path(POSTAL_PATH);
     path += "/" + m_pkgName;
 
-    qDebug(postalClient) << "Clearing persistent notifications for tags:" << tags;
-    qDebug(postalClient) << "D-Bus path:" << path;
+    qCDebug(postalClient) << "Clearing persistent notifications for tags:" << tags;
+    qCDebug(postalClient) << "D-Bus path:" << path;
 
     QDBusMessage message = QDBusMessage::createMethodCall(
         POSTAL_SERVICE, path, POSTAL_IFACE, "ClearPersistent");
@@ -95,24 +101,45 @@ void PostalClient::clearPersistent(const QStringList &tags)
     }
 
     QDBusPendingCall pcall = bus.asyncCall(message);
-    // Fire and forget - don't wait for response
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(pcall, this);
+    connect(watcher, SIGNAL(finished(QDBusPendingCallWatcher *)),
+            this, SLOT(clearPersistentFinished(QDBusPendingCallWatcher *)));
+    if (m_tracker)
+    {
+        m_tracker->track(watcher, "ClearPersistent");
+    }
+}
+
+void PostalClient::clearPersistentFinished(QDBusPendingCallWatcher *watcher)
+{
+    QDBusPendingReply<void> reply = *watcher;
+    if (reply.isError())
+    {
+        qCWarning(postalClient) << "ClearPersistent D-Bus call failed:" << reply.error().message();
+    }
+    else
+    {
+        qCDebug(postalClient) << "Persistent notifications cleared";
+    }
+    watcher->deleteLater();
 }
 
 void PostalClient::post(const QString &message)
 {
+    TRACE_SCOPE("PostalClient::post");
     QDBusConnection bus = QDBusConnection::sessionBus();
     if (!bus.isConnected())
     {
-        qWarning(postalClient) << "D-Bus session bus not connected";
+        qCWarning(postalClient) << "D-Bus session bus not connected";
         return;
     }
 
     QString path(POSTAL_PATH);
     path += "/" + m_pkgName;
 
-    qDebug(postalClient) << "Posting notification to Postal service";
-    qDebug(postalClient) << "D-Bus path:" << path;
-    qDebug(postalClient) << "Message:" << message;
+    qCDebug(postalClient) << "Posting notification to Postal service";
+    qCDebug(postalClient) << "D-Bus path:" << path;
+    qCDebug(postalClient) << "Message:" << message;
 
     QDBusMessage dbusMessage = QDBusMessage::createMethodCall(
         POSTAL_SERVICE, path, POSTAL_IFACE, "Post");
@@ -122,64 +149,27 @@ void PostalClient::post(const QString &message)
     QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(pcall, this);
     connect(watcher, SIGNAL(finished(QDBusPendingCallWatcher *)),
             this, SLOT(postFinished(QDBusPendingCallWatcher *)));
+    if (m_tracker)
+    {
+        m_tracker->track(watcher, "Post");
+    }
 }
 
 void PostalClient::postNotification(const QString &tag, const QString &summary, const QString &body, const QString &icon, const QVariantMap &actions)
 {
-    QDBusConnection bus = QDBusConnection::sessionBus();
-    if (!bus.isConnected())
-    {
-        qWarning(postalClient) << "D-Bus session bus not connected";
-        return;
-    }
-
-    QString path(POSTAL_PATH);
-    path += "/" + m_pkgName;
-
     // Build notification in Ubuntu Touch standard format
     // According to UBports docs: data.notification.card structure
-    QJsonObject card;
-    card["summary"] = summary;
-    card["body"] = body;
-    card["icon"] = icon.isEmpty() ? "notification" : icon;
-    card["persist"] = true;  // Show in notification center
-    card["popup"] = true;    // Show as popup banner
-    
-    QJsonObject notification;
-    notification["card"] = card;
-    notification["tag"] = tag;
-    notification["vibrate"] = true;
-    notification["sound"] = true;
-    
-    // Add actions if provided (makes notification clickable)
-    if (!actions.isEmpty())
-    {
-        QJsonArray actionsArray;
-        for (auto it = actions.constBegin(); it != actions.constEnd(); ++it)
-        {
-            actionsArray.append(it.key());
-        }
-        card["actions"] = actionsArray;
-    }
-    
-    QJsonObject root;
-    root["notification"] = notification;
-    
-    QJsonDocument doc(root);
-    QString notificationJson = QString::fromUtf8(doc.toJson(QJsonDocument::Compact));
-
-    qDebug(postalClient) << "Posting persistent notification to Postal service";
-    qDebug(postalClient) << "D-Bus path:" << path;
-    qDebug(postalClient) << "Notification JSON:" << notificationJson;
+    NotificationCard card;
+    card.summary = summary;
+    card.body = body;
+    card.icon = icon;
+    card.tag = tag;
+    card.actions = actions.keys();
 
-    QDBusMessage dbusMessage = QDBusMessage::createMethodCall(
-        POSTAL_SERVICE, path, POSTAL_IFACE, "Post");
-    dbusMessage << m_appId << notificationJson;
+    QByteArray notificationJson;
+    card.serialize(notificationJson);
 
-    QDBusPendingCall pcall = bus.asyncCall(dbusMessage);
-    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(pcall, this);
-    connect(watcher, SIGNAL(finished(QDBusPendingCallWatcher *)),
-            this, SLOT(postFinished(QDBusPendingCallWatcher *)));
+    post(QString::fromUtf8(notificationJson));
 }
 
 void PostalClient::postFinished(QDBusPendingCallWatcher *watcher)
@@ -187,11 +177,11 @@ void PostalClient::postFinished(QDBusPendingCallWatcher *watcher)
     QDBusPendingReply<void> reply = *watcher;
     if (reply.isError())
     {
-        qWarning(postalClient) << "Post D-Bus call failed:" << reply.error().message();
+        qCWarning(postalClient) << "Post D-Bus call failed:" << reply.error().message();
     }
     else
     {
-        qDebug(postalClient) << "Notification posted successfully to Postal service";
+        qCDebug(postalClient) << "Notification posted successfully to Postal service";
     }
     watcher->deleteLater();
 }
@@ -15,6 +15,8 @@
 #include <QStringList>
 #include <QVariantMap>
 
+#include "pending-call-tracker.h"
+
 #define POSTAL_SERVICE "com.lomiri.Postal"
 #define POSTAL_PATH "/com/lomiri/Postal"
 #define POSTAL_IFACE "com.lomiri.Postal"
@@ -26,6 +28,9 @@ class PostalClient : public QObject
 public:
     explicit PostalClient(QString appId, QObject *parent = nullptr);
 
+    // Report every call to tracker so callers can wait for completion
+    void setCallTracker(PendingCallTracker *tracker) { m_tracker = tracker; }
+
     void setCount(int count);
     void clearPersistent(const QStringList &tags);
     void post(const QString &message);
@@ -34,8 +39,10 @@ public:
 private Q_SLOTS:
     void setCountFinished(QDBusPendingCallWatcher *watcher);
     void postFinished(QDBusPendingCallWatcher *watcher);
+    void clearPersistentFinished(QDBusPendingCallWatcher *watcher);
 
 private:
     QString m_appId;
     QString m_pkgName;
+    PendingCallTracker *m_tracker;
 };
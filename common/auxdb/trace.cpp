@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * Trace implementation
+ */
+
+#include "trace.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QStandardPaths>
+#include <QDebug>
+#include <QLoggingCategory>
+
+#include <atomic>
+#include <cstring>
+
+Q_LOGGING_CATEGORY(traceLog, "trace")
+
+namespace {
+
+struct TraceEvent
+{
+    const char *category;
+    const char *name;
+    qint64 start;
+    qint64 duration;
+};
+
+// Enough for a few hundred jobs between flushes; older events are
+// overwritten rather than growing the buffer
+const quint32 Capacity = 4096;
+
+TraceEvent *events = nullptr;
+std::atomic<quint32> nextEvent(0);
+
+bool initTrace()
+{
+    QByteArray value = qgetenv("PUSH_HELPER_TRACE");
+    if (value.isEmpty() || value == "0") {
+        return false;
+    }
+
+    // Allocated once up front so recording never allocates
+    events = new TraceEvent[Capacity];
+    qAddPostRoutine(Trace::flush);
+    return true;
+}
+
+} // namespace
+
+bool Trace::s_enabled = initTrace();
+
+void Trace::complete(const char *category, const char *name, qint64 startNs, qint64 endNs)
+{
+    if (!s_enabled) {
+        return;
+    }
+
+    TraceEvent &event = events[nextEvent.fetch_add(1) % Capacity];
+    event.category = category;
+    event.name = name;
+    event.start = startNs;
+    event.duration = endNs - startNs;
+}
+
+void Trace::flush()
+{
+    quint32 count = s_enabled ? nextEvent.exchange(0) : 0;
+    if (count == 0) {
+        return;
+    }
+
+    QString directory = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(directory);
+    QFile file(directory + "/push-trace.json");
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qCWarning(traceLog) << "Cannot open trace file:" << file.fileName();
+        return;
+    }
+
+    // The JSON array format allows the closing bracket to be left off,
+    // which lets every flush simply append
+    QByteArray out;
+    if (file.size() == 0) {
+        out.append("[\n");
+    }
+
+    const qint64 pid = QCoreApplication::applicationPid();
+    const quint32 first = count > Capacity ? count - Capacity : 0;
+    char line[256];
+    for (quint32 i = first; i < count; ++i) {
+        const TraceEvent &event = events[i % Capacity];
+        // D-Bus round trips overlap the stages, so they get their own track
+        int tid = strcmp(event.category, "dbus") == 0 ? 2 : 1;
+        int size = qsnprintf(line, sizeof(line),
+                             "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+                             "\"pid\":%lld,\"tid\":%d},\n",
+                             event.name, event.category, event.start / 1000.0, event.duration / 1000.0,
+                             pid, tid);
+        out.append(line, qMin(size, int(sizeof(line)) - 1));
+    }
+
+    file.write(out);
+    qCDebug(traceLog) << "Wrote" << count - first << "trace events to" << file.fileName();
+}
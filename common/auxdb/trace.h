@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * Trace - Per-stage timing for the push pipeline
+ *
+ * Set PUSH_HELPER_TRACE=1 to record scoped timings into an in-memory ring
+ * buffer, appended as Chrome trace events (chrome://tracing, Perfetto) to
+ * push-trace.json in the app data dir when a job finishes. When unset a
+ * TRACE_SCOPE costs one branch: nothing is formatted or allocated.
+ */
+
+#pragma once
+
+#include <QtGlobal>
+
+#include <chrono>
+
+class Trace
+{
+public:
+    static bool enabled() { return s_enabled; }
+
+    static qint64 now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Records a finished span; category and name are kept by pointer, so
+    // they must be string literals
+    static void complete(const char *category, const char *name, qint64 startNs, qint64 endNs);
+
+    // Appends the buffered events to the trace file and empties the buffer
+    static void flush();
+
+private:
+    static bool s_enabled;
+};
+
+class TraceScope
+{
+public:
+    explicit TraceScope(const char *name)
+        : m_name(name), m_start(Trace::enabled() ? Trace::now() : -1) {}
+
+    ~TraceScope()
+    {
+        if (m_start >= 0) {
+            Trace::complete("push", m_name, m_start, Trace::now());
+        }
+    }
+
+private:
+    Q_DISABLE_COPY(TraceScope)
+
+    const char *m_name;
+    qint64 m_start;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+// Times the rest of the enclosing block
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
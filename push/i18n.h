@@ -13,3 +13,7 @@ const QString GETTEXT_DOMAIN = "pushnotification.surajyadav";
 
 #define _(value) gettext(value)
 #define N_(value) gettext(value)
+
+// Marks a string for translation without looking it up; for static tables
+// whose entries are passed through gettext() when they are used
+#define N_NOOP(value) value
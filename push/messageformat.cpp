@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * MessageFormatRegistry implementation
+ *
+ * New message types are added as rows in FORMATS. If the static_assert
+ * below fires after adding one, bump HASH_SEED until it passes again.
+ */
+
+#include "messageformat.h"
+#include "pushmessage.h"
+#include "i18n.h"
+
+#include <QVector>
+
+namespace {
+
+constexpr MessageFormat FORMATS[] = {
+    // Direct messages
+    { "MESSAGE_TEXT", "%2", 2, false },
+    { "MESSAGE_PHOTO", N_NOOP("sent you a photo"), 0, true },
+    { "MESSAGE_VIDEO", N_NOOP("sent you a video"), 0, true },
+    { "MESSAGE_AUDIO", N_NOOP("sent you an audio message"), 0, true },
+    { "MESSAGE_VOICE_NOTE", N_NOOP("sent you a voice message"), 0, true },
+    { "MESSAGE_STICKER", N_NOOP("sent you a sticker"), 0, true },
+    { "MESSAGE_DOC", N_NOOP("sent you a document"), 0, true },
+    { "MESSAGE_CONTACT", N_NOOP("shared a contact with you"), 0, true },
+    { "MESSAGE_GEO", N_NOOP("sent you a location"), 0, true },
+    { "MESSAGE_NOTEXT", N_NOOP("sent you a message"), 0, true },
+
+    // Group messages: sender: message
+    { "CHAT_MESSAGE_TEXT", "%1: %3", 3, false },
+    { "CHAT_MESSAGE_PHOTO", N_NOOP("%1 sent a photo to the group"), 0, true },
+    { "CHAT_MESSAGE_VIDEO", N_NOOP("%1 sent a video to the group"), 0, true },
+    { "CHAT_CREATED", N_NOOP("%1 invited you to the group"), 0, true },
+    { "CHAT_ADD_YOU", N_NOOP("%1 invited you to the group"), 0, true },
+
+    { "NEW_MESSAGE", N_NOOP("You have a new message"), 0, true },
+};
+
+constexpr int FORMAT_COUNT = int(sizeof(FORMATS) / sizeof(FORMATS[0]));
+constexpr MessageFormat FALLBACK_FORMAT = { "", N_NOOP("You have a new message"), 0, true };
+
+constexpr quint32 HASH_SEED = 5;
+constexpr int SLOT_COUNT = 64;
+
+static_assert(FORMAT_COUNT < SLOT_COUNT, "Grow SLOT_COUNT for the number of message formats");
+
+constexpr quint32 hashKey(std::string_view key)
+{
+    // FNV-1a
+    quint32 hash = 2166136261u ^ HASH_SEED;
+    for (char c : key) {
+        hash ^= quint8(c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+struct SlotTable
+{
+    qint8 slots[SLOT_COUNT];
+};
+
+constexpr SlotTable buildSlots()
+{
+    SlotTable table = {};
+    for (int i = 0; i < SLOT_COUNT; ++i) {
+        table.slots[i] = -1;
+    }
+    for (int i = 0; i < FORMAT_COUNT; ++i) {
+        int slot = int(hashKey(FORMATS[i].locKey) % SLOT_COUNT);
+        while (table.slots[slot] != -1) {
+            slot = (slot + 1) % SLOT_COUNT;
+        }
+        table.slots[slot] = qint8(i);
+    }
+    return table;
+}
+
+constexpr SlotTable SLOTS = buildSlots();
+
+constexpr bool isPerfect()
+{
+    for (int i = 0; i < FORMAT_COUNT; ++i) {
+        if (SLOTS.slots[hashKey(FORMATS[i].locKey) % SLOT_COUNT] != i) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(isPerfect(), "loc_key hash collision, pick another HASH_SEED");
+
+// A template split into literal text and loc_args slots
+struct Segment
+{
+    int arg;
+    QString text;
+};
+
+typedef QVector<Segment> Template;
+
+Template parseTemplate(const QString &text)
+{
+    Template segments;
+    QString literal;
+    for (int i = 0; i < text.size(); ++i) {
+        if (text.at(i) == '%' && i + 1 < text.size() && text.at(i + 1) >= '1' && text.at(i + 1) <= '9') {
+            if (!literal.isEmpty()) {
+                segments.append({ -1, literal });
+                literal.clear();
+            }
+            segments.append({ text.at(i + 1).digitValue() - 1, QString() });
+            ++i;
+        } else {
+            literal.append(text.at(i));
+        }
+    }
+    if (!literal.isEmpty()) {
+        segments.append({ -1, literal });
+    }
+    return segments;
+}
+
+// Templates are parsed (and translated) the first time a type is seen;
+// the helper is single-threaded, so no locking is needed
+const Template &cachedTemplate(int index)
+{
+    static Template cache[FORMAT_COUNT + 1];
+    static bool parsed[FORMAT_COUNT + 1] = {};
+
+    if (!parsed[index]) {
+        const MessageFormat &format = index < FORMAT_COUNT ? FORMATS[index] : FALLBACK_FORMAT;
+        const char *text = format.translated ? gettext(format.text) : format.text;
+        cache[index] = parseTemplate(QString::fromUtf8(text));
+        parsed[index] = true;
+    }
+    return cache[index];
+}
+
+} // namespace
+
+const MessageFormat *MessageFormatRegistry::find(std::string_view locKey)
+{
+    int index = SLOTS.slots[hashKey(locKey) % SLOT_COUNT];
+    if (index >= 0 && FORMATS[index].locKey == locKey) {
+        return &FORMATS[index];
+    }
+    return nullptr;
+}
+
+QString MessageFormatRegistry::render(const PushEvent &message)
+{
+    const MessageFormat *format = find(message.locKey);
+    int index = format && message.locArgCount >= format->minArgs ? int(format - FORMATS) : FORMAT_COUNT;
+
+    QString body;
+    for (const Segment &segment : cachedTemplate(index)) {
+        if (segment.arg < 0) {
+            body.append(segment.text);
+        } else if (segment.arg < message.locArgCount) {
+            std::string_view arg = message.locArgs[segment.arg];
+            body.append(QString::fromUtf8(arg.data(), int(arg.size())));
+        }
+    }
+    return body;
+}
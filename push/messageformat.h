@@ -0,0 +1,34 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * MessageFormat - Table of notification body templates keyed by loc_key
+ */
+
+#pragma once
+
+#include <QString>
+
+#include <string_view>
+
+struct PushEvent;
+
+// How one loc_key is rendered into the notification body. In text, %1..%9
+// refer to loc_args by position. Translated templates go through gettext()
+// once per process and are cached pre-parsed.
+struct MessageFormat
+{
+    std::string_view locKey;
+    const char *text;
+    int minArgs;
+    bool translated;
+};
+
+class MessageFormatRegistry
+{
+public:
+    // Single probe into a compile-time perfect hash of all known loc_keys
+    static const MessageFormat *find(std::string_view locKey);
+
+    // Unknown types and messages with too few loc_args get the generic body
+    static QString render(const PushEvent &message);
+};
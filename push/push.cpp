@@ -11,18 +11,47 @@
 
 #include <QCoreApplication>
 #include <QTimer>
+#include <QElapsedTimer>
 #include <QLoggingCategory>
 #include <QStringList>
 #include <QDebug>
 
 #include "pushhelper.h"
+#include "../common/auxdb/trace.h"
+#ifndef PUSH_LITE
+#include "pushdaemon.h"
+#endif
 
 Q_DECLARE_LOGGING_CATEGORY(pushHelper)
 
 int main(int argc, char *argv[])
 {
-    if (argc != 3) {
-        qFatal("Usage: %s infile outfile", argv[0]);
+    QElapsedTimer launched;
+    launched.start();
+    
+    // Exec to main() as seen by whoever spawned us, for push_startup_bench
+    if (Trace::enabled()) {
+        qint64 spawnedNs = qgetenv("PUSH_HELPER_SPAWN_NS").toLongLong();
+        if (spawnedNs > 0) {
+            Trace::complete("push", "exec to main()", spawnedNs, Trace::now());
+        }
+    }
+    
+#ifdef PUSH_LITE
+    // The lite build has no resident daemon, it would need QtNetwork
+    bool daemonMode = false;
+#else
+    bool daemonMode = argc == 2 && qstrcmp(argv[1], "--daemon") == 0;
+#endif
+    bool batchMode = argc == 3 && qstrcmp(argv[1], "--batch") == 0;
+    bool singleMode = !daemonMode && !batchMode;
+    if (argc != 3 && !daemonMode) {
+#ifdef PUSH_LITE
+        qFatal("Usage: %s infile outfile\n       %s --batch spooldir", argv[0], argv[0]);
+#else
+        qFatal("Usage: %s infile outfile\n       %s --batch spooldir\n       %s --daemon",
+               argv[0], argv[0], argv[0]);
+#endif
     }
     
     QCoreApplication app(argc, argv);
@@ -36,17 +65,55 @@ int main(int argc, char *argv[])
     // Disable auxdb logging for performance
     QLoggingCategory::setFilterRules("auxdb=false");
     
-    qDebug(pushHelper) << "Push helper started with args:" << args;
+    qCDebug(pushHelper) << "Push helper started with args:" << args;
+    
+#ifndef PUSH_LITE
+    // Hand the job to a resident helper if one is running, so we skip
+    // opening the database and connecting to the session bus ourselves.
+    // Once it has taken the job it alone handles the message.
+    if (singleMode) {
+        PushDaemon::ForwardResult forwarded = PushDaemon::forward(args.at(1), args.at(2));
+        if (forwarded == PushDaemon::Delivered) {
+            qCDebug(pushHelper) << "Push message handled by push daemon";
+            return 0;
+        }
+        if (forwarded == PushDaemon::Failed) {
+            qCWarning(pushHelper) << "Push daemon failed the message";
+            return 1;
+        }
+    }
+#endif
     
     // Create and process push notification
     PushHelper pushHelper("pushnotification.surajyadav_pushnotification",
-                          QString(args.at(1)), QString(args.at(2)), &app);
+                          singleMode ? QString(args.at(1)) : QString(),
+                          singleMode ? QString(args.at(2)) : QString(), &app);
     
-    QObject::connect(&pushHelper, SIGNAL(done()), &app, SLOT(quit()));
-    pushHelper.process();
+#ifndef PUSH_LITE
+    if (daemonMode) {
+        // Keep the engine alive and serve jobs until we are killed
+        PushDaemon daemon(&pushHelper, &app);
+        if (!daemon.listen()) {
+            return 1;
+        }
+        return app.exec();
+    }
+#endif
+    
+    pushHelper.setLaunchTime(launched);
+    
+    // Queued, so a done() emitted before exec() still ends the event loop
+    QObject::connect(&pushHelper, &PushHelper::done, &app, &QCoreApplication::quit, Qt::QueuedConnection);
+    if (batchMode) {
+        // Drain every pending *.in file, writing <name>.out next to it
+        pushHelper.processBatch(args.at(2));
+    } else {
+        pushHelper.process();
+    }
     
-    // Fallback timeout to ensure app exits
-    QTimer::singleShot(1000, &app, SLOT(quit()));
+    // Fallback timeout to ensure app exits; done() normally fires as soon
+    // as the last D-Bus reply arrives or its own deadline expires
+    QTimer::singleShot(3000, &app, SLOT(quit()));
     
     return app.exec();
 }
@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * PushDaemon implementation
+ */
+
+#include "pushdaemon.h"
+#include "pushhelper.h"
+
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QStandardPaths>
+#include <QDebug>
+#include <QLoggingCategory>
+
+Q_LOGGING_CATEGORY(pushDaemon, "pushDaemon")
+
+PushDaemon::PushDaemon(PushHelper *helper, QObject *parent)
+    : QObject(parent), m_helper(helper), m_server(new QLocalServer(this))
+{
+    // The socket lives in the user's runtime dir, so restricting it to the
+    // owner keeps other users from feeding jobs to the helper
+    m_server->setSocketOptions(QLocalServer::UserAccessOption);
+
+    connect(m_server, &QLocalServer::newConnection, this, &PushDaemon::newConnection);
+}
+
+bool PushDaemon::listen()
+{
+    QString name = socketName();
+
+    // A stale socket file is left behind if a previous daemon was killed
+    QLocalServer::removeServer(name);
+
+    if (!m_server->listen(name))
+    {
+        qCWarning(pushDaemon) << "Cannot listen on" << name << ":" << m_server->errorString();
+        return false;
+    }
+
+    qCDebug(pushDaemon) << "Push daemon listening on" << m_server->fullServerName();
+    return true;
+}
+
+PushDaemon::ForwardResult PushDaemon::forward(const QString &infile, const QString &outfile, int timeoutMs)
+{
+    QLocalSocket socket;
+    socket.connectToServer(socketName());
+
+    // Connecting to a missing socket fails immediately, so this only waits
+    // when a daemon is alive but busy accepting
+    if (!socket.waitForConnected(100))
+    {
+        qCDebug(pushDaemon) << "No push daemon running:" << socket.errorString();
+        return NoDaemon;
+    }
+
+    QDataStream out(&socket);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << infile << outfile;
+
+    if (!socket.waitForBytesWritten(timeoutMs))
+    {
+        qCWarning(pushDaemon) << "Failed to hand job to push daemon:" << socket.errorString();
+        return NoDaemon;
+    }
+
+    // From here on the daemon may be running the job, so it is its answer
+    // or a failure; processing the message here as well would post and
+    // count it twice
+
+    QDataStream in(&socket);
+    in.setVersion(QDataStream::Qt_5_0);
+
+    bool ok = false;
+    while (true)
+    {
+        in.startTransaction();
+        in >> ok;
+        if (in.commitTransaction())
+        {
+            break;
+        }
+        if (!socket.waitForReadyRead(timeoutMs))
+        {
+            qCWarning(pushDaemon) << "Push daemon did not answer:" << socket.errorString();
+            return Failed;
+        }
+    }
+
+    socket.disconnectFromServer();
+    return ok ? Delivered : Failed;
+}
+
+QString PushDaemon::socketName()
+{
+    QString name = qEnvironmentVariable("PUSH_HELPER_SOCKET");
+    if (!name.isEmpty())
+    {
+        return name;
+    }
+
+    return QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation)
+        + "/" + QCoreApplication::applicationName() + ".push";
+}
+
+void PushDaemon::newConnection()
+{
+    while (QLocalSocket *socket = m_server->nextPendingConnection())
+    {
+        connect(socket, &QLocalSocket::readyRead, this, &PushDaemon::readJob);
+        connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+
+        // The job may already be buffered by the time we see the connection
+        if (socket->bytesAvailable() > 0)
+        {
+            handleJob(socket);
+        }
+    }
+}
+
+void PushDaemon::readJob()
+{
+    handleJob(qobject_cast<QLocalSocket *>(sender()));
+}
+
+void PushDaemon::handleJob(QLocalSocket *socket)
+{
+    if (!socket)
+    {
+        return;
+    }
+
+    QDataStream in(socket);
+    in.setVersion(QDataStream::Qt_5_0);
+
+    QString infile, outfile;
+    in.startTransaction();
+    in >> infile >> outfile;
+    if (!in.commitTransaction())
+    {
+        // Wait for the rest of the job to arrive
+        return;
+    }
+
+    qCDebug(pushDaemon) << "Processing job:" << infile << "->" << outfile;
+    // The shim reports a failed job rather than process it again, since
+    // its database updates and D-Bus calls may already have been made
+    bool ok = m_helper->process(infile, outfile);
+    if (!ok)
+    {
+        qCWarning(pushDaemon) << "Push daemon failed job:" << infile << "->" << outfile;
+    }
+
+    QDataStream out(socket);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << ok;
+    socket->flush();
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * PushDaemon - Resident push helper serving (infile, outfile) jobs
+ * over a local socket, so the database and D-Bus connections stay warm
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QString>
+
+class PushHelper;
+
+class PushDaemon : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PushDaemon(PushHelper *helper, QObject *parent = nullptr);
+
+    bool listen();
+
+    enum ForwardResult
+    {
+        // No daemon took the job; the caller should process the message
+        // in-process
+        NoDaemon,
+        Delivered,
+        // The daemon took the job and failed it or did not answer in time.
+        // It may have applied part of it, so the message must not be
+        // processed again.
+        Failed
+    };
+
+    // Hands a job to a running daemon
+    static ForwardResult forward(const QString &infile, const QString &outfile, int timeoutMs = 2000);
+
+    static QString socketName();
+
+private Q_SLOTS:
+    void newConnection();
+    void readJob();
+
+private:
+    void handleJob(QLocalSocket *socket);
+
+    PushHelper *m_helper;
+    QLocalServer *m_server;
+};
@@ -5,424 +5,819 @@
  */
 
 #include "pushhelper.h"
+#include "messageformat.h"
 #include "i18n.h"
+#include "../common/auxdb/trace.h"
 
-#include <QJsonDocument>
-#include <QJsonObject>
-#include <QJsonArray>
 #include <QFile>
+#include <QSaveFile>
+#include <QFileInfo>
 #include <QDebug>
 #include <QLoggingCategory>
 #include <QDir>
+#include <QDateTime>
+#include <QHash>
 
 #include <locale.h>
 
 Q_LOGGING_CATEGORY(pushHelper, "pushHelper")
 
+const QString PushHelper::REJECTED_DIR = QStringLiteral("rejected");
+
+static QString auxDatabaseDirectory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation).append("/auxdb");
+}
+
+// An unset or unparsable override keeps the default
+static int envInt(const char *name, int defaultValue)
+{
+    bool ok = false;
+    int value = qEnvironmentVariableIntValue(name, &ok);
+    return ok ? value : defaultValue;
+}
+
 PushHelper::PushHelper(const QString appId, const QString infile, const QString outfile, QObject *parent)
-    : QObject(parent), mInfile(infile), mOutfile(outfile), 
-      m_postalClient(new PostalClient(appId)),
-      m_notificationClient(new NotificationClient(appId)),
-      m_auxdb(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation).append("/auxdb"),
-              QGuiApplication::applicationDirPath().append("/assets"), this)
+    : QObject(parent), mInfile(infile), mOutfile(outfile), m_appId(appId),
+      m_callTracker(CALL_DEADLINE_MS),
+      m_postalClient(nullptr),
+      m_notificationClient(nullptr),
+      m_auxdb(nullptr),
+      m_translationsReady(false),
+      m_finishing(false),
+      m_budgeted(true),
+      m_budgetMs(envInt("PUSH_HELPER_BUDGET_MS", DEFAULT_BUDGET_MS)),
+      m_coalesceMs(envInt("PUSH_HELPER_COALESCE_MS", DEFAULT_COALESCE_MS)),
+      m_backlogMin(envInt("PUSH_HELPER_BACKLOG_MIN", DEFAULT_BACKLOG_MIN)),
+      m_backlogAgeMs(envInt("PUSH_HELPER_BACKLOG_AGE_MS", DEFAULT_BACKLOG_AGE_MS)),
+      m_outfileReadyNs(-1),
+      m_traceJobStart(-1)
 {
-    qDebug(pushHelper) << "PushHelper initialized";
-    qDebug(pushHelper) << "Input file:" << mInfile;
-    qDebug(pushHelper) << "Output file:" << mOutfile;
+    connect(&m_callTracker, &PendingCallTracker::idle, this, &PushHelper::callsFinished);
 
-    // Set up internationalization
-    setlocale(LC_ALL, "");
-    textdomain(GETTEXT_DOMAIN.toStdString().c_str());
+    qCDebug(pushHelper) << "PushHelper initialized";
+    qCDebug(pushHelper) << "Input file:" << mInfile;
+    qCDebug(pushHelper) << "Output file:" << mOutfile;
+}
+
+void PushHelper::setLaunchTime(const QElapsedTimer &launched)
+{
+    m_jobTimer = launched;
+}
+
+bool PushHelper::process()
+{
+    return process(mInfile, mOutfile);
 }
 
-void PushHelper::process()
+bool PushHelper::process(const QString &infile, const QString &outfile)
 {
-    qDebug(pushHelper) << "Starting push message processing";
+    mInfile = infile;
+    mOutfile = outfile;
+    startJob(true);
+
+    qCDebug(pushHelper) << "Starting push message processing";
 
-    QJsonObject pushMessage = readPushMessage(mInfile);
-    if (pushMessage.isEmpty())
+    PushMessage pushMessage;
+    if (!pushMessage.readFile(mInfile))
     {
-        qWarning(pushHelper) << "Failed to read push message from" << mInfile;
-        Q_EMIT done();
-        return;
+        qCWarning(pushHelper) << "Failed to read push message from" << mInfile;
+        finish();
+        return false;
     }
 
-    // Extract message data
-    QJsonObject message = pushMessage["message"].toObject();
-    if (message.isEmpty())
+    // Read receipts and friends are a large share of our traffic; decide
+    // before any locale, database or bus work so they cost one file read
+    if (shouldSkip(pushMessage))
     {
-        qDebug(pushHelper) << "No message object found";
-        Q_EMIT done();
-        return;
+        finish();
+        return true;
     }
 
-    QString locKey = message["loc_key"].toString();
-    QJsonArray locArgs = message["loc_args"].toArray();
-    QJsonObject custom = message["custom"].toObject();
-    int badge = message["badge"].toInt();
+    // A payload may carry several events; all of them are formatted first
+    // so their database updates can share one transaction
+    QList<PushNotification> notifications;
+    buildNotifications(pushMessage, notifications);
 
-    qDebug(pushHelper) << "Message type:" << locKey;
-    qDebug(pushHelper) << "Message args:" << locArgs;
-    qDebug(pushHelper) << "Badge count:" << badge;
+    // The unread total goes into the outfile's emblem counter, so it is
+    // part of the critical path; both queries are O(1)
+    qint32 totalCount = 0;
+    bool badgeChanged = updateChatState(notifications, true, totalCount);
 
-    // Handle special cases
-    if (locKey.isEmpty() || locKey == "READ_HISTORY")
+    QVector<int> cardOf;
+    QList<PushNotification> cards = mergeByChat(notifications, cardOf);
+
+    // Serialize each card once; the same bytes go to the outfile and to Postal
+    QVector<QByteArray> &cardJson = m_cardJson;
+    cardJson.resize(cards.size());
+    for (int i = 0; i < cards.size(); ++i)
     {
-        qDebug(pushHelper) << "Skipping notification for type:" << locKey;
-        Q_EMIT done();
-        return;
+        NotificationCard &card = cards[i].card;
+        card.emblemCount = cards.at(i).badge > 0 ? totalCount : 0;
+        card.serialize(cardJson[i]);
     }
 
-    // Extract chat ID
-    qint64 chatId = extractChatId(custom);
-    if (chatId == 0)
+    // Write notification JSON to output file (required by Ubuntu Touch push system).
+    // This is all the push service waits for, so it goes out first; with
+    // several events it carries the card of the latest one.
+    bool written = !cardOf.isEmpty() && writeOutputFile(cardJson.at(cardOf.last()));
+    outfileReady();
+
+    // Everything below duplicates what the outfile already carries and
+    // only runs while we are within the latency budget
+    for (int i = 0; i < cards.size(); ++i)
     {
-        qWarning(pushHelper) << "Could not determine chat ID";
+        sendNotification(cards.at(i), cardJson.at(i));
     }
 
-    // Format notification message
-    QString summary, body;
-    if (locArgs.size() > 0)
+    if (badgeChanged && withinBudget("badge update"))
     {
-        summary = locArgs[0].toString(); // Usually sender name
+        postalClient()->setCount(totalCount);
+        qCDebug(pushHelper) << "Updated badge count to:" << totalCount;
     }
-    else
+
+    qCDebug(pushHelper) << "Push message processing completed";
+
+    finish();
+    return written;
+}
+
+void PushHelper::processBatch(const QString &spoolDir)
+{
+    // The budget is per push, and a drain's side effects come after all of
+    // its outfiles; it already makes one call per chat instead of per push
+    startJob(false);
+
+    QDir dir(spoolDir);
+    QFileInfoList pending = dir.entryInfoList(QStringList() << "*.in", QDir::Files, QDir::Name);
+
+    qCDebug(pushHelper) << "Draining" << pending.size() << "push messages from" << spoolDir;
+
+    // A full spool means the device was offline for a while
+    qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
+    bool backlog = m_backlogMin > 0 && pending.size() >= m_backlogMin;
+
+    // Decode and format everything first so the database work below
+    // can run as one short transaction. A file may hold several events;
+    // its outfile carries the card of the last one.
+    QList<PushNotification> notifications;
+    QStringList infiles;
+    QStringList outfiles;
+    QVector<int> lastOf;
+    QStringList handled;
+    for (const QFileInfo &info : pending)
+    {
+        PushMessage pushMessage;
+        if (!pushMessage.readFile(info.filePath()))
+        {
+            // Reading it again will not help; keep it out of later drains
+            qCWarning(pushHelper) << "Failed to read push message from" << info.filePath();
+            reject(dir, info);
+        }
+        else if (shouldSkip(pushMessage))
+        {
+            handled.append(info.filePath());
+        }
+        else
+        {
+            backlog = backlog || (m_backlogMin > 0 && isStale(pushMessage, nowMs));
+            buildNotifications(pushMessage, notifications);
+            infiles.append(info.filePath());
+            outfiles.append(dir.filePath(info.completeBaseName() + ".out"));
+            lastOf.append(notifications.size() - 1);
+        }
+    }
+
+    // A backlog skips the per-message burst state, it is collapsed below
+    qint32 totalCount = 0;
+    bool badgeChanged = updateChatState(notifications, !backlog, totalCount);
+
+    // One card per chat; cardOf maps each notification to its card. A
+    // backlog gets silent cards and a cross-chat summary instead.
+    QVector<int> cardOf;
+    QList<PushNotification> cards = backlog ? collapseBacklog(notifications, cardOf)
+                                            : mergeByChat(notifications, cardOf);
+
+    QVector<QByteArray> &cardJson = m_cardJson;
+    cardJson.resize(cards.size());
+    for (int i = 0; i < cards.size(); ++i)
     {
-        summary = "Push Notification";
+        NotificationCard &card = cards[i].card;
+        card.emblemCount = cards.at(i).badge > 0 ? totalCount : 0;
+        card.serialize(cardJson[i]);
     }
 
-    body = formatNotificationMessage(locKey, locArgs);
-    if (body.isEmpty())
+    int unwritten = 0;
+    for (int i = 0; i < outfiles.size(); ++i)
     {
-        qDebug(pushHelper) << "No body text for message type:" << locKey;
-        body = "You have a new message";
+        mOutfile = outfiles.at(i);
+        if (writeOutputFile(cardJson.at(cardOf.at(lastOf.at(i)))))
+        {
+            handled.append(infiles.at(i));
+        }
+        else
+        {
+            ++unwritten;
+        }
     }
+    outfileReady();
 
-    // Get avatar (if available)
-    QString avatar = m_auxdb.getAvatarMapTable()->getAvatarPathbyId(chatId);
-    if (avatar.isEmpty())
+    for (int i = 0; i < cards.size(); ++i)
     {
-        avatar = "notification"; // Default icon
+        sendNotification(cards.at(i), cardJson.at(i));
     }
 
-    // Generate unique tag for this notification
-    QString tag = QString("chat_%1").arg(chatId);
-
-    // Send notification to notification panel using org.freedesktop.Notifications (for popup)
-    qDebug(pushHelper) << "Sending notification popup:" << summary << "-" << body;
-    m_notificationClient->notify(summary, body, avatar);
-
-    // Also post to Postal service for persistent notification in panel
-    qDebug(pushHelper) << "Posting persistent notification with tag:" << tag;
-    m_postalClient->postNotification(tag, summary, body, avatar);
-
-    // Update badge counter using Postal service (this part still works)
-    qint32 totalCount = 0;
-    if (badge > 0 && chatId != 0)
+    // One badge update for the whole batch instead of one per message
+    if (badgeChanged && withinBudget("badge update"))
     {
-        m_auxdb.getAvatarMapTable()->setUnreadMapEntry(chatId, badge);
-        totalCount = m_auxdb.getAvatarMapTable()->getTotalUnread();
-        m_postalClient->setCount(totalCount);
-        qDebug(pushHelper) << "Updated badge count to:" << totalCount;
+        postalClient()->setCount(totalCount);
+        qCDebug(pushHelper) << "Updated badge count to:" << totalCount;
     }
 
-    // Write notification JSON to output file (required by Ubuntu Touch push system)
-    writeOutputFile(summary, body, avatar, tag, totalCount);
+    // Inputs whose outfile was committed, or that we deliberately do not
+    // show, leave the spool; those whose outfile failed are retried on the
+    // next drain
+    for (const QString &infile : qAsConst(handled))
+    {
+        QFile::remove(infile);
+    }
+    if (unwritten > 0)
+    {
+        qCWarning(pushHelper) << "Left" << unwritten << "push messages in" << spoolDir;
+    }
 
-    qDebug(pushHelper) << "Push message processing completed";
+    qCDebug(pushHelper) << "Processed" << outfiles.size() << "of" << pending.size() << "push messages into"
+                        << cards.size() << "cards";
 
-    Q_EMIT done();
+    finish();
 }
 
-QJsonObject PushHelper::readPushMessage(const QString &filename)
+void PushHelper::reject(const QDir &spool, const QFileInfo &info)
 {
-    QFile file(filename);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    QString rejected = spool.filePath(REJECTED_DIR + "/" + info.fileName());
+    spool.mkpath(REJECTED_DIR);
+    QFile::remove(rejected);
+    if (!QFile::rename(info.filePath(), rejected))
     {
-        qWarning(pushHelper) << "Cannot open input file:" << filename;
-        return QJsonObject();
+        qCWarning(pushHelper) << "Cannot move" << info.filePath() << "aside, removing it";
+        QFile::remove(info.filePath());
     }
+}
 
-    QString val = file.readAll();
-    file.close();
-
-    QJsonParseError parseError;
-    QJsonDocument doc = QJsonDocument::fromJson(val.toUtf8(), &parseError);
+void PushHelper::startJob(bool budgeted)
+{
+    m_budgeted = budgeted;
 
-    if (parseError.error != QJsonParseError::NoError)
+    // A cold start measures from main(), see setLaunchTime()
+    if (!m_jobTimer.isValid())
     {
-        qWarning(pushHelper) << "JSON parse error:" << parseError.errorString();
-        return QJsonObject();
+        m_jobTimer.start();
     }
+    m_outfileReadyNs = -1;
+    m_traceJobStart = Trace::enabled() ? Trace::now() : -1;
+}
 
-    qDebug(pushHelper) << "Successfully read push message:" << doc.object();
-    return doc.object();
+void PushHelper::outfileReady()
+{
+    m_outfileReadyNs = m_jobTimer.nsecsElapsed();
+    qCInfo(pushHelper) << "Outfile ready after" << m_outfileReadyNs / 1000 << "us";
 }
 
-QJsonObject PushHelper::pushToPostalMessage(const QJsonObject &pushMessage)
+bool PushHelper::withinBudget(const char *step) const
 {
-    // Extract message data
-    QJsonObject message = pushMessage["message"].toObject();
-    if (message.isEmpty())
+    qint64 elapsedMs = m_jobTimer.elapsed();
+    if (!m_budgeted || elapsedMs <= m_budgetMs)
     {
-        qDebug(pushHelper) << "No message object found";
-        return QJsonObject();
+        return true;
     }
 
-    QString locKey = message["loc_key"].toString();
-    QJsonArray locArgs = message["loc_args"].toArray();
-    QJsonObject custom = message["custom"].toObject();
-    int badge = message["badge"].toInt();
+    qCInfo(pushHelper) << "Skipping" << step << "- over latency budget by" << elapsedMs - m_budgetMs << "ms";
+    return false;
+}
 
-    qDebug(pushHelper) << "Message type:" << locKey;
-    qDebug(pushHelper) << "Message args:" << locArgs;
-    qDebug(pushHelper) << "Badge count:" << badge;
+void PushHelper::finish()
+{
+    m_jobTimer.invalidate();
 
-    // Handle special cases
-    if (locKey.isEmpty() || locKey == "READ_HISTORY")
+    // Replies to the Notify/Post/SetCounter calls arrive on the event loop;
+    // hold done() back until the tracker has seen them all
+    if (m_callTracker.pendingCount() > 0)
     {
-        qDebug(pushHelper) << "Skipping notification for type:" << locKey;
-        return QJsonObject();
+        qCDebug(pushHelper) << "Waiting for" << m_callTracker.pendingCount() << "D-Bus calls";
+        m_finishing = true;
+        return;
     }
 
-    // Extract chat ID
-    qint64 chatId = extractChatId(custom);
-    if (chatId == 0)
-    {
-        qWarning(pushHelper) << "Could not determine chat ID";
-        return QJsonObject();
-    }
+    callsFinished();
+    emitDone();
+}
 
-    // Update unread count in database
-    if (badge > 0)
+void PushHelper::callsFinished()
+{
+    QStringList timedOut = m_callTracker.takeTimedOut();
+    if (!timedOut.isEmpty())
     {
-        m_auxdb.getAvatarMapTable()->setUnreadMapEntry(chatId, badge);
-        qint32 totalCount = m_auxdb.getAvatarMapTable()->getTotalUnread();
-
-        // Update badge counter
-        m_postalClient->setCount(totalCount);
-        qDebug(pushHelper) << "Updated badge count to:" << totalCount;
+        qCWarning(pushHelper) << "D-Bus calls timed out:" << timedOut;
     }
 
-    // Clear old notifications for this chat
-    m_postalClient->clearPersistent(QStringList(QString::number(chatId)));
-
-    // Format notification message
-    QString summary, body;
-    if (locArgs.size() > 0)
+    if (m_finishing)
     {
-        summary = locArgs[0].toString(); // Usually sender name
+        m_finishing = false;
+        emitDone();
     }
-    else
+}
+
+PostalClient *PushHelper::postalClient()
+{
+    if (!m_postalClient)
     {
-        summary = "Push Notification";
+        m_postalClient = new PostalClient(m_appId, this);
+        m_postalClient->setCallTracker(&m_callTracker);
     }
+    return m_postalClient;
+}
 
-    body = formatNotificationMessage(locKey, locArgs);
-    if (body.isEmpty())
+NotificationClient *PushHelper::notificationClient()
+{
+    if (!m_notificationClient)
     {
-        qDebug(pushHelper) << "No body text for message type:" << locKey;
-        return QJsonObject();
+        m_notificationClient = new NotificationClient(m_appId, this);
+        m_notificationClient->setCallTracker(&m_callTracker);
     }
+    return m_notificationClient;
+}
 
-    // Get avatar (if available)
-    QString avatar = m_auxdb.getAvatarMapTable()->getAvatarPathbyId(chatId);
-    if (avatar.isEmpty())
+AuxDatabase *PushHelper::auxDatabase()
+{
+    // Opening the database runs its pragmas and migrations, by far the
+    // most expensive part of a cold start
+    if (!m_auxdb)
     {
-        avatar = "notification-symbolic"; // Default Ubuntu Touch icon
+        TRACE_SCOPE("PushHelper::openAuxDatabase");
+        m_auxdb = new AuxDatabase(auxDatabaseDirectory(), QCoreApplication::applicationDirPath().append("/assets"), this);
     }
+    return m_auxdb;
+}
 
-    // Create action URL for deep linking
-    QString actionUrl = QString("pushnotification://chat/%1").arg(chatId);
-
-    // Build postal notification
-    QJsonObject card;
-    card["summary"] = summary;
-    card["body"] = body;
-    card["popup"] = true;
-    card["persist"] = true;
-    card["icon"] = avatar;
-
-    QJsonArray actions;
-    actions.append(actionUrl);
-    card["actions"] = actions;
-
-    QJsonObject notification;
-    notification["card"] = card;
-    notification["sound"] = true;
-    notification["tag"] = QString::number(chatId);
-    notification["vibrate"] = true;
+AvatarMapTable *PushHelper::avatarMapTable()
+{
+    return auxDatabase()->getAvatarMapTable();
+}
 
-    QJsonObject result;
-    result["notification"] = notification;
+QString PushHelper::avatarPath(qint64 chatId)
+{
+    // The read-only index answers without SQLite; it is remapped only
+    // when the app has rebuilt it since the last job
+    if (m_avatarIndex.open(AvatarIndex::pathIn(auxDatabaseDirectory())))
+    {
+        return m_avatarIndex.lookup(chatId);
+    }
 
-    qDebug(pushHelper) << "Created postal message:" << result;
-    return result;
+    // No index yet; a slow database start falls back to the default icon
+    AvatarMapTable *avatars = withinBudget("avatar lookup") ? avatarMapTable() : nullptr;
+    return avatars ? avatars->getAvatarPathbyId(chatId) : QString();
 }
 
-void PushHelper::writePostalMessage(const QJsonObject &postalMessage, const QString &filename)
+void PushHelper::initTranslations()
 {
-    QFile file(filename);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    if (m_translationsReady)
     {
-        qWarning(pushHelper) << "Cannot open output file:" << filename;
         return;
     }
+    m_translationsReady = true;
 
-    QJsonDocument doc(postalMessage);
-    file.write(doc.toJson());
-    file.close();
+    // Set up internationalization
+    setlocale(LC_ALL, "");
+    textdomain(GETTEXT_DOMAIN.toStdString().c_str());
+}
 
-    qDebug(pushHelper) << "Wrote postal message to:" << filename;
+void PushHelper::emitDone()
+{
+    // The job span runs until the last D-Bus reply; the trace file is
+    // written here, after the outfile and all calls are out of the way
+    if (m_traceJobStart >= 0)
+    {
+        Trace::complete("push", "PushHelper::job", m_traceJobStart, Trace::now());
+        Trace::flush();
+    }
+
+    Q_EMIT done();
 }
 
-QString PushHelper::formatNotificationMessage(const QString &messageType, const QJsonArray &args)
+bool PushHelper::shouldSkip(const PushMessage &message)
 {
-    // Handle different message types
-    if (messageType == "MESSAGE_TEXT" && args.size() >= 2)
+    if (!message.hasMessage)
     {
-        return args[1].toString(); // Direct message text
+        qCDebug(pushHelper) << "No message object found";
+        return true;
     }
-    else if (messageType == "MESSAGE_PHOTO")
+
+    // The push service may still hand us messages that expired while the
+    // device was offline; the server no longer wants them shown
+    qint64 expiresAt = message.expiresAtMs();
+    if (expiresAt >= 0 && expiresAt <= QDateTime::currentMSecsSinceEpoch())
     {
-        return N_("sent you a photo");
+        qCDebug(pushHelper) << "Dropping expired message:" << PushEvent::toString(message.expireOn);
+        return true;
     }
-    else if (messageType == "MESSAGE_VIDEO")
+
+    for (int i = 0; i < message.eventCount(); ++i)
     {
-        return N_("sent you a video");
+        if (!shouldSkipEvent(message.event(i)))
+        {
+            return false;
+        }
     }
-    else if (messageType == "MESSAGE_AUDIO")
+    return true;
+}
+
+bool PushHelper::shouldSkipEvent(const PushEvent &event)
+{
+    // Handle special cases
+    if (event.locKey.empty() || event.locKey == "READ_HISTORY")
+    {
+        qCDebug(pushHelper) << "Skipping notification for type:" << PushEvent::toString(event.locKey);
+        return true;
+    }
+
+    return false;
+}
+
+bool PushHelper::isStale(const PushMessage &message, qint64 nowMs) const
+{
+    for (int i = 0; i < message.eventCount(); ++i)
     {
-        return N_("sent you an audio message");
+        qint64 sentAt = message.event(i).sentAtMs();
+        if (sentAt >= 0 && nowMs - sentAt > m_backlogAgeMs)
+        {
+            return true;
+        }
     }
-    else if (messageType == "MESSAGE_VOICE_NOTE")
+    return false;
+}
+
+void PushHelper::buildNotifications(const PushMessage &message, QList<PushNotification> &notifications)
+{
+    for (int i = 0; i < message.eventCount(); ++i)
     {
-        return N_("sent you a voice message");
+        const PushEvent &event = message.event(i);
+        if (!shouldSkipEvent(event))
+        {
+            notifications.append(PushNotification());
+            buildNotification(event, notifications.last());
+        }
     }
-    else if (messageType == "MESSAGE_STICKER")
+}
+
+void PushHelper::buildNotification(const PushEvent &message, PushNotification &notification)
+{
+    notification.badge = message.badge;
+
+    qCDebug(pushHelper) << "Message type:" << PushEvent::toString(message.locKey);
+    qCDebug(pushHelper) << "Message arg count:" << message.locArgCount;
+    qCDebug(pushHelper) << "Badge count:" << notification.badge;
+
+    // Extract chat ID
+    notification.chatId = extractChatId(message);
+    if (notification.chatId == 0)
     {
-        return N_("sent you a sticker");
+        qCWarning(pushHelper) << "Could not determine chat ID";
     }
-    else if (messageType == "MESSAGE_DOC")
+
+    NotificationCard &card = notification.card;
+
+    // Format notification message
+    if (message.locArgCount > 0)
     {
-        return N_("sent you a document");
+        card.summary = message.locArg(0); // Usually sender name
     }
-    else if (messageType == "MESSAGE_CONTACT")
+    else
     {
-        return N_("shared a contact with you");
+        card.summary = "Push Notification";
     }
-    else if (messageType == "MESSAGE_GEO")
+
+    card.body = formatNotificationMessage(message);
+    if (card.body.isEmpty())
     {
-        return N_("sent you a location");
+        qCDebug(pushHelper) << "No body text for message type:" << PushEvent::toString(message.locKey);
+        card.body = "You have a new message";
     }
-    else if (messageType == "MESSAGE_NOTEXT")
+
+    // Get avatar (if available)
+    card.icon = avatarPath(notification.chatId);
+    if (card.icon.isEmpty())
     {
-        return N_("sent you a message");
+        card.icon = "notification"; // Default icon
     }
-    else if (messageType == "CHAT_MESSAGE_TEXT" && args.size() >= 3)
+
+    // Generate unique tag for this notification
+    card.tag = QString("chat_%1").arg(notification.chatId);
+
+    // Create action URL for deep linking
+    if (notification.chatId != 0)
     {
-        // Group message: sender: message
-        return QString("%1: %2").arg(args[0].toString()).arg(args[2].toString());
+        card.actions = QStringList(QString("pushnotification://chat/%1").arg(notification.chatId));
     }
-    else if (messageType == "CHAT_MESSAGE_PHOTO")
+}
+
+void PushHelper::coalesce(PushNotification &notification, bool fresh)
+{
+    if (m_coalesceMs <= 0 || notification.chatId == 0)
     {
-        return QString(N_("%1 sent a photo to the group")).arg(args[0].toString());
+        return;
     }
-    else if (messageType == "CHAT_MESSAGE_VIDEO")
+
+    // The burst state lives in auxdb so separate helper processes see
+    // each other's messages
+    ChatBurstTable *bursts = auxDatabase()->getChatBurstTable();
+    if (!bursts)
     {
-        return QString(N_("%1 sent a video to the group")).arg(args[0].toString());
+        return;
     }
-    else if (messageType == "CHAT_CREATED")
+
+    NotificationCard &card = notification.card;
+    ChatBurst burst = bursts->addMessage(notification.chatId, card.body, QDateTime::currentMSecsSinceEpoch(),
+                                         m_coalesceMs, MAX_BURST_LINES, fresh);
+    if (burst.count <= 1)
     {
-        return QString(N_("%1 invited you to the group")).arg(args[0].toString());
+        return;
     }
-    else if (messageType == "CHAT_ADD_YOU")
+
+    // Same tag, so the card replaces the one from the first message; only
+    // that first message pops up, plays a sound or vibrates
+    card.body = newMessagesText(burst.count) + "\n" + burst.lines.join("\n");
+    card.popup = false;
+    card.sound = false;
+    card.vibrate = false;
+
+    qCDebug(pushHelper) << "Coalesced" << burst.count << "messages for chat" << notification.chatId;
+}
+
+bool PushHelper::updateChatState(QList<PushNotification> &notifications, bool coalesceBursts, qint32 &totalCount)
+{
+    QVector<QPair<qint64, qint32>> unreadEntries;
+    bool bursts = false;
+    for (const PushNotification &notification : notifications)
+    {
+        if (notification.chatId == 0)
+        {
+            continue;
+        }
+        if (notification.badge > 0)
+        {
+            unreadEntries.append(qMakePair(notification.chatId, qint32(notification.badge)));
+        }
+        bursts = bursts || (coalesceBursts && m_coalesceMs > 0);
+    }
+
+    // Coalescing takes the write lock even for a message without a badge,
+    // and may wait there for other helpers; past the budget the message
+    // goes out as its own card instead
+    if (bursts && !withinBudget("burst coalescing"))
+    {
+        bursts = false;
+        coalesceBursts = false;
+    }
+
+    bool badgeChanged = !unreadEntries.isEmpty();
+    if (!badgeChanged && !bursts)
+    {
+        return false;
+    }
+
+    // Other helpers may be updating counts at the same time; set and read
+    // back under one write lock so the total includes our update. The
+    // burst updates join the same transaction.
+    AuxDatabase *db = auxDatabase();
+    db->transaction();
+    if (coalesceBursts)
+    {
+        // Read receipts never reach the database, so a read chat shows up
+        // as its unread count dropping below the one stored for it; that
+        // message starts a new burst rather than bringing back lines
+        // already seen. A missing badge says nothing either way.
+        AvatarMapTable *unread = db->getAvatarMapTable();
+        QHash<qint64, int> lastBadge;
+        for (PushNotification &notification : notifications)
+        {
+            bool fresh = false;
+            if (notification.chatId != 0 && notification.badge > 0 && unread)
+            {
+                auto last = lastBadge.find(notification.chatId);
+                int stored = last != lastBadge.end() ? last.value() : unread->getUnreadCount(notification.chatId);
+                fresh = notification.badge < stored;
+                lastBadge.insert(notification.chatId, notification.badge);
+            }
+            coalesce(notification, fresh);
+        }
+    }
+
+    AvatarMapTable *avatars = badgeChanged ? db->getAvatarMapTable() : nullptr;
+    if (avatars)
+    {
+        avatars->setUnreadMapEntries(unreadEntries);
+        totalCount = avatars->getTotalUnread();
+    }
+    db->commit();
+
+    return badgeChanged;
+}
+
+QList<PushNotification> PushHelper::mergeByChat(const QList<PushNotification> &notifications, QVector<int> &cardOf)
+{
+    // A chat's cards share a tag, so each one replaces the one before it
+    // in the panel anyway. Only the latest is posted, with the attention
+    // of any message in the chat that would have popped up on its own.
+    QList<PushNotification> cards;
+    QHash<qint64, int> cardOfChat;
+    cardOf.resize(notifications.size());
+    for (int i = 0; i < notifications.size(); ++i)
+    {
+        const PushNotification &notification = notifications.at(i);
+        int index = cardOfChat.value(notification.chatId, -1);
+        if (index < 0)
+        {
+            index = cards.size();
+            cardOfChat.insert(notification.chatId, index);
+            cards.append(notification);
+        }
+        else
+        {
+            const NotificationCard &previous = cards.at(index).card;
+            bool popup = previous.popup || notification.card.popup;
+            bool sound = previous.sound || notification.card.sound;
+            bool vibrate = previous.vibrate || notification.card.vibrate;
+
+            cards[index] = notification;
+            cards[index].card.popup = popup;
+            cards[index].card.sound = sound;
+            cards[index].card.vibrate = vibrate;
+        }
+        cardOf[i] = index;
+    }
+    return cards;
+}
+
+QList<PushNotification> PushHelper::collapseBacklog(const QList<PushNotification> &notifications, QVector<int> &cardOf)
+{
+    TRACE_SCOPE("PushHelper::collapseBacklog");
+
+    // The latest message of a chat provides its card, the latest lines
+    // its body
+    QList<PushNotification> cards = mergeByChat(notifications, cardOf);
+    QVector<int> counts(cards.size());
+    QVector<QStringList> lines(cards.size());
+    for (int i = 0; i < notifications.size(); ++i)
+    {
+        int index = cardOf.at(i);
+        ++counts[index];
+        lines[index].append(notifications.at(i).card.body.simplified());
+        if (lines.at(index).size() > MAX_BURST_LINES)
+        {
+            lines[index].removeFirst();
+        }
+    }
+
+    int total = 0;
+    int badge = 0;
+    QStringList chatLines;
+    for (int i = 0; i < cards.size(); ++i)
+    {
+        NotificationCard &card = cards[i].card;
+        if (counts.at(i) > 1)
+        {
+            card.body = newMessagesText(counts.at(i)) + "\n" + lines.at(i).join("\n");
+        }
+
+        // Only the cross-chat summary below gets attention
+        card.popup = false;
+        card.sound = false;
+        card.vibrate = false;
+
+        total += counts.at(i);
+        badge += cards.at(i).badge;
+        if (chatLines.size() < MAX_BURST_LINES)
+        {
+            chatLines.append(QString("%1 (%2)").arg(card.summary).arg(counts.at(i)));
+        }
+    }
+
+    // With a single chat its own card is the summary
+    if (cards.size() == 1)
+    {
+        NotificationCard &card = cards.first().card;
+        card.popup = true;
+        card.sound = true;
+        card.vibrate = true;
+    }
+    else if (cards.size() > 1)
+    {
+        // Not tied to a chat; the badge only makes it carry the emblem counter
+        PushNotification summary;
+        summary.badge = badge;
+        summary.card.summary = newMessagesText(total);
+        summary.card.body = chatLines.join("\n");
+        summary.card.icon = "notification";
+        summary.card.tag = "backlog";
+        cards.append(summary);
+    }
+
+    qCInfo(pushHelper) << "Collapsed a backlog of" << total << "messages into" << counts.size() << "chats";
+    return cards;
+}
+
+QString PushHelper::newMessagesText(int count)
+{
+    initTranslations();
+    return QString::fromUtf8(ngettext("%1 new message", "%1 new messages", count)).arg(count);
+}
+
+void PushHelper::sendNotification(const PushNotification &notification, const QByteArray &cardJson)
+{
+    TRACE_SCOPE("PushHelper::sendNotification");
+    const NotificationCard &card = notification.card;
+
+    // Send notification to notification panel using org.freedesktop.Notifications (for popup)
+    if (card.popup && withinBudget("notification popup"))
     {
-        return QString(N_("%1 invited you to the group")).arg(args[0].toString());
+        qCDebug(pushHelper) << "Sending notification popup:" << card.summary << "-" << card.body;
+        notificationClient()->notify(card.summary, card.body, card.icon);
     }
-    else if (messageType == "NEW_MESSAGE")
+
+    // Also post to Postal service for persistent notification in panel
+    if (withinBudget("postal post"))
     {
-        return N_("You have a new message");
+        qCDebug(pushHelper) << "Posting persistent notification with tag:" << card.tag;
+        postalClient()->post(QString::fromUtf8(cardJson));
     }
-    else
+}
+
+QString PushHelper::formatNotificationMessage(const PushEvent &message)
+{
+    TRACE_SCOPE("PushHelper::formatNotificationMessage");
+    initTranslations();
+
+    if (!MessageFormatRegistry::find(message.locKey))
     {
-        qDebug(pushHelper) << "Unhandled message type:" << messageType;
-        return N_("You have a new message");
+        qCDebug(pushHelper) << "Unhandled message type:" << PushEvent::toString(message.locKey);
     }
+
+    return MessageFormatRegistry::render(message);
 }
 
-qint64 PushHelper::extractChatId(const QJsonObject &custom)
+qint64 PushHelper::extractChatId(const PushEvent &message)
 {
+    TRACE_SCOPE("PushHelper::extractChatId");
     qint64 chatId = 0;
 
     // Try different chat ID fields
-    if (custom.contains("from_id"))
+    if (message.fromId.data())
     {
         // Private chat: Use user ID directly
-        chatId = custom["from_id"].toString().toLongLong();
+        chatId = PushEvent::toLongLong(message.fromId);
     }
-    else if (custom.contains("chat_id"))
+    else if (message.chatId.data())
     {
         // Basic group: Negate the group ID
-        chatId = custom["chat_id"].toString().toLongLong() * -1;
+        chatId = PushEvent::toLongLong(message.chatId) * -1;
     }
-    else if (custom.contains("channel_id"))
+    else if (message.channelId.data())
     {
         // Supergroup/Channel: Apply transformation
-        qint64 channelId = custom["channel_id"].toString().toLongLong();
+        qint64 channelId = PushEvent::toLongLong(message.channelId);
         chatId = (channelId + 1000000000000LL) * -1;
     }
-    else if (custom.contains("id"))
+    else if (message.id.data())
     {
         // Generic ID field
-        chatId = custom["id"].toString().toLongLong();
+        chatId = PushEvent::toLongLong(message.id);
     }
 
-    qDebug(pushHelper) << "Extracted chat ID:" << chatId;
+    qCDebug(pushHelper) << "Extracted chat ID:" << chatId;
     return chatId;
 }
 
-void PushHelper::writeOutputFile(const QString &summary, const QString &body, const QString &icon, const QString &tag, int count)
+bool PushHelper::writeOutputFile(const QByteArray &notificationJson)
 {
-    // Build notification output in Ubuntu Touch format
-    QJsonObject card;
-    card["summary"] = summary;
-    card["body"] = body;
-    card["icon"] = icon;
-    card["persist"] = true;
-    card["popup"] = true;
-    
-    QJsonObject notification;
-    notification["card"] = card;
-    notification["tag"] = tag;
-    notification["vibrate"] = true;
-    notification["sound"] = true;
-    
-    // Add emblem counter if count > 0
-    if (count > 0)
+    TRACE_SCOPE("PushHelper::writeOutputFile");
+
+    // Write to output file; QSaveFile renames into place on commit so the
+    // push service never sees a half-written notification
+    QSaveFile outFile(mOutfile);
+    if (!outFile.open(QIODevice::WriteOnly | QIODevice::Text))
     {
-        QJsonObject emblem;
-        emblem["count"] = count;
-        emblem["visible"] = true;
-        notification["emblem-counter"] = emblem;
+        qCWarning(pushHelper) << "Cannot open output file:" << mOutfile;
+        return false;
     }
     
-    QJsonObject root;
-    root["notification"] = notification;
-    
-    QJsonDocument doc(root);
-    
-    // Write to output file
-    QFile outFile(mOutfile);
-    if (!outFile.open(QIODevice::WriteOnly | QIODevice::Text))
+    outFile.write(notificationJson);
+    if (!outFile.commit())
     {
-        qWarning(pushHelper) << "Cannot open output file:" << mOutfile;
-        return;
+        qCWarning(pushHelper) << "Cannot write output file:" << mOutfile << outFile.errorString();
+        return false;
     }
     
-    outFile.write(doc.toJson(QJsonDocument::Compact));
-    outFile.close();
-    
-    qDebug(pushHelper) << "Wrote notification to output file:" << mOutfile;
-    qDebug(pushHelper) << "Notification JSON:" << QString::fromUtf8(doc.toJson(QJsonDocument::Compact));
+    qCDebug(pushHelper) << "Wrote notification to output file:" << mOutfile;
+    qCDebug(pushHelper) << "Notification JSON:" << notificationJson;
+    return true;
 }
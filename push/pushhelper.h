@@ -8,16 +8,31 @@
 #pragma once
 
 #include <QObject>
-#include <QJsonObject>
-#include <QJsonDocument>
 #include <QFile>
+#include <QDir>
+#include <QFileInfo>
 #include <QStandardPaths>
-#include <QGuiApplication>
+#include <QCoreApplication>
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QList>
+#include <QVector>
 
+#include "pushmessage.h"
 #include "../common/auxdb/postal-client.h"
 #include "../common/auxdb/notification-client.h"
+#include "../common/auxdb/notification-card.h"
+#include "../common/auxdb/pending-call-tracker.h"
 #include "../common/auxdb/auxdatabase.h"
+#include "../common/auxdb/avatarindex.h"
+
+// A push message rendered into what we show to the user
+struct PushNotification
+{
+    NotificationCard card;
+    qint64 chatId = 0;
+    int badge = 0;
+};
 
 class PushHelper : public QObject
 {
@@ -26,25 +41,116 @@ class PushHelper : public QObject
 public:
     explicit PushHelper(const QString appId, const QString infile, const QString outfile, QObject *parent = nullptr);
     
-    void process();
+    // Return whether the message was handled: its outfile was committed,
+    // or it is one we deliberately do not show
+    bool process();
+    bool process(const QString &infile, const QString &outfile);
+    void processBatch(const QString &spoolDir);
+    
+    // Start the latency clock at process launch instead of at process()
+    void setLaunchTime(const QElapsedTimer &launched);
+    
+    // Time from launch (or job start in daemon mode) until the outfile was
+    // committed for the last job, or -1 if none was written
+    qint64 outfileReadyNs() const { return m_outfileReadyNs; }
 
 Q_SIGNALS:
+    // Processing is complete and every D-Bus call it made has been
+    // answered or has run past its deadline
     void done();
 
+private Q_SLOTS:
+    void callsFinished();
+
 private:
-    QJsonObject readPushMessage(const QString &filename);
-    QJsonObject pushToPostalMessage(const QJsonObject &pushMessage);
-    void writePostalMessage(const QJsonObject &postalMessage, const QString &filename);
-    void writeOutputFile(const QString &summary, const QString &body, const QString &icon, const QString &tag, int count);
+    void startJob(bool budgeted);
+    
+    // Moves a spool input we cannot read into REJECTED_DIR
+    static void reject(const QDir &spool, const QFileInfo &info);
+    void outfileReady();
+    bool withinBudget(const char *step) const;
+    void finish();
+    void emitDone();
+    
+    // Subsystems are created on first use, so a message we do not show
+    // never opens the database or connects to the session bus
+    PostalClient *postalClient();
+    NotificationClient *notificationClient();
+    AuxDatabase *auxDatabase();
+    AvatarMapTable *avatarMapTable();
+    QString avatarPath(qint64 chatId);
+    void initTranslations();
+    
+    static bool shouldSkip(const PushMessage &message);
+    static bool shouldSkipEvent(const PushEvent &event);
+    bool isStale(const PushMessage &message, qint64 nowMs) const;
+    void buildNotifications(const PushMessage &message, QList<PushNotification> &notifications);
+    void buildNotification(const PushEvent &message, PushNotification &notification);
     
-    QString formatNotificationMessage(const QString &messageType, const QJsonArray &args);
-    qint64 extractChatId(const QJsonObject &custom);
+    // Coalesces bursts and writes the unread counts of all notifications
+    // in one write transaction. Returns whether the badge changed and sets
+    // totalCount to the new total if so.
+    bool updateChatState(QList<PushNotification> &notifications, bool coalesceBursts, qint32 &totalCount);
+    // fresh starts a new burst, for a chat the user has read since
+    void coalesce(PushNotification &notification, bool fresh);
+    
+    // One card per chat, in order of first appearance; cardOf[i] is the
+    // card that notification i ended up on
+    QList<PushNotification> mergeByChat(const QList<PushNotification> &notifications, QVector<int> &cardOf);
+    QList<PushNotification> collapseBacklog(const QList<PushNotification> &notifications, QVector<int> &cardOf);
+    QString newMessagesText(int count);
+    void sendNotification(const PushNotification &notification, const QByteArray &cardJson);
+    bool writeOutputFile(const QByteArray &notificationJson);
+    
+    QString formatNotificationMessage(const PushEvent &message);
+    qint64 extractChatId(const PushEvent &message);
     
     QString mInfile;
     QString mOutfile;
-    QJsonObject mPostalMessage;
     
+    // Serialized cards of the current job; kept so a resident helper
+    // reuses the buffers
+    QVector<QByteArray> m_cardJson;
+    
+    QString m_appId;
+    PendingCallTracker m_callTracker;
     PostalClient *m_postalClient;
     NotificationClient *m_notificationClient;
-    AuxDatabase m_auxdb;
+    AuxDatabase *m_auxdb;
+    AvatarIndex m_avatarIndex;
+    bool m_translationsReady;
+    bool m_finishing;
+    QElapsedTimer m_jobTimer;
+    bool m_budgeted;
+    int m_budgetMs;
+    int m_coalesceMs;
+    int m_backlogMin;
+    int m_backlogAgeMs;
+    qint64 m_outfileReadyNs;
+    qint64 m_traceJobStart;
+    
+    // Side effects beyond the outfile are skipped once a single-message job
+    // has run this long; PUSH_HELPER_BUDGET_MS overrides it
+    static constexpr int DEFAULT_BUDGET_MS = 250;
+    
+    // Messages to a chat within this long of the first one are merged into
+    // one card that does not pop up or play a sound again;
+    // PUSH_HELPER_COALESCE_MS overrides it, 0 turns coalescing off
+    static constexpr int DEFAULT_COALESCE_MS = 60000;
+    
+    // A batch is drained as an offline backlog when it holds this many
+    // messages or any message was sent more than DEFAULT_BACKLOG_AGE_MS
+    // ago; PUSH_HELPER_BACKLOG_MIN and PUSH_HELPER_BACKLOG_AGE_MS override
+    // them, a minimum of 0 turns backlog collapsing off
+    static constexpr int DEFAULT_BACKLOG_MIN = 10;
+    static constexpr int DEFAULT_BACKLOG_AGE_MS = 5 * 60 * 1000;
+    
+    // Spool subdirectory for inputs that cannot be read or decoded
+    static const QString REJECTED_DIR;
+    
+    // Message lines shown on a merged card
+    static constexpr int MAX_BURST_LINES = 3;
+    
+    // How long we wait for any single D-Bus reply before giving up on it
+    static constexpr int CALL_DEADLINE_MS = 1000;
 };
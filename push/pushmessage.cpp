@@ -0,0 +1,758 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * PushMessage implementation
+ *
+ * Small single-pass JSON and CBOR scanners that walk the payload once,
+ * pick out loc_key, loc_args, badge, date and the chat ids in custom from
+ * the "message" object or from each object of the "messages" array, and
+ * the top-level expire_on, and skip everything else without building a
+ * DOM.
+ */
+
+#include "pushmessage.h"
+#include "../common/auxdb/trace.h"
+
+#include <QFile>
+#include <QCborStreamReader>
+#include <QDateTime>
+#include <QDebug>
+#include <QLoggingCategory>
+
+#include <cctype>
+#include <charconv>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+Q_LOGGING_CATEGORY(pushMessage, "pushMessage")
+
+namespace {
+
+const int MaxDepth = 32;
+
+class JsonScanner
+{
+public:
+    JsonScanner(char *begin, char *end) : m_pos(begin), m_end(end) {}
+
+    bool parsePayload(PushMessage &message)
+    {
+        bool ok = parseObject([&](std::string_view key) {
+            if (key == "message") {
+                return peek() == '{' ? parseEvent(message) : skipValue(1);
+            } else if (key == "messages") {
+                return parseEvents(message);
+            } else if (key == "expire_on") {
+                return parseScalar(message.expireOn);
+            } else if (key == "cbor") {
+                return parseScalar(m_cbor);
+            }
+            return skipValue(1);
+        });
+        skipWhitespace();
+        return ok && m_pos == m_end;
+    }
+
+    // Base64 text of a CBOR payload wrapped in JSON, if there was one
+    std::string_view cbor() const { return m_cbor; }
+
+private:
+    // The first event fills the message itself, later ones go to more
+    bool parseEvent(PushMessage &message)
+    {
+        if (!message.hasMessage) {
+            message.hasMessage = true;
+            return parseMessage(message);
+        }
+        message.more.append(PushEvent());
+        return parseMessage(message.more.last());
+    }
+
+    bool parseEvents(PushMessage &message)
+    {
+        if (peek() != '[') {
+            return skipValue(1);
+        }
+        ++m_pos;
+        skipWhitespace();
+        if (peek() == ']') {
+            ++m_pos;
+            return true;
+        }
+        while (true) {
+            if (!(peek() == '{' ? parseEvent(message) : skipValue(2))) {
+                return false;
+            }
+            skipWhitespace();
+            if (peek() == ',') {
+                ++m_pos;
+                skipWhitespace();
+            } else if (peek() == ']') {
+                ++m_pos;
+                return true;
+            } else {
+                return false;
+            }
+        }
+    }
+
+    bool parseMessage(PushEvent &message)
+    {
+        return parseObject([&](std::string_view key) {
+            if (key == "loc_key") {
+                return parseScalar(message.locKey);
+            } else if (key == "loc_args") {
+                return parseLocArgs(message);
+            } else if (key == "badge") {
+                return parseInt(message.badge);
+            } else if (key == "custom") {
+                return parseCustom(message);
+            } else if (key == "date") {
+                return parseScalar(message.date);
+            }
+            return skipValue(2);
+        });
+    }
+
+    bool parseLocArgs(PushEvent &message)
+    {
+        message.locArgCount = 0;
+        if (peek() != '[') {
+            return skipValue(2);
+        }
+        ++m_pos;
+        skipWhitespace();
+        if (peek() == ']') {
+            ++m_pos;
+            return true;
+        }
+        while (true) {
+            // Like QJsonValue::toString(), non-string arguments read as empty
+            std::string_view arg;
+            if (peek() == '"') {
+                if (!parseString(arg)) {
+                    return false;
+                }
+            } else if (!skipValue(3)) {
+                return false;
+            }
+            if (message.locArgCount < PushEvent::MaxLocArgs) {
+                message.locArgs[message.locArgCount++] = arg;
+            }
+            skipWhitespace();
+            if (peek() == ',') {
+                ++m_pos;
+                skipWhitespace();
+            } else if (peek() == ']') {
+                ++m_pos;
+                return true;
+            } else {
+                return false;
+            }
+        }
+    }
+
+    bool parseCustom(PushEvent &message)
+    {
+        if (peek() != '{') {
+            return skipValue(2);
+        }
+        return parseObject([&](std::string_view key) {
+            if (key == "from_id") {
+                return parseScalar(message.fromId);
+            } else if (key == "chat_id") {
+                return parseScalar(message.chatId);
+            } else if (key == "channel_id") {
+                return parseScalar(message.channelId);
+            } else if (key == "id") {
+                return parseScalar(message.id);
+            }
+            return skipValue(3);
+        });
+    }
+
+    // Calls handler(key) with the cursor on each member value
+    template <typename Handler>
+    bool parseObject(Handler handler)
+    {
+        skipWhitespace();
+        if (peek() != '{') {
+            return false;
+        }
+        ++m_pos;
+        skipWhitespace();
+        if (peek() == '}') {
+            ++m_pos;
+            return true;
+        }
+        while (true) {
+            std::string_view key;
+            if (peek() != '"' || !parseString(key)) {
+                return false;
+            }
+            skipWhitespace();
+            if (peek() != ':') {
+                return false;
+            }
+            ++m_pos;
+            skipWhitespace();
+            if (!handler(key)) {
+                return false;
+            }
+            skipWhitespace();
+            if (peek() == ',') {
+                ++m_pos;
+                skipWhitespace();
+            } else if (peek() == '}') {
+                ++m_pos;
+                return true;
+            } else {
+                return false;
+            }
+        }
+    }
+
+    // Strings yield their decoded text, other scalars their literal text
+    bool parseScalar(std::string_view &value)
+    {
+        if (peek() == '"') {
+            return parseString(value);
+        }
+        char *start = m_pos;
+        while (m_pos < m_end && (isalnum(uchar(*m_pos)) || *m_pos == '-' || *m_pos == '+' || *m_pos == '.')) {
+            ++m_pos;
+        }
+        if (m_pos == start) {
+            return false;
+        }
+        value = std::string_view(start, size_t(m_pos - start));
+        return true;
+    }
+
+    bool parseInt(int &value)
+    {
+        std::string_view literal;
+        if (peek() == '"' || peek() == '{' || peek() == '[') {
+            // Matches QJsonValue::toInt(): non-numbers count as zero
+            value = 0;
+            return skipValue(2);
+        }
+        if (!parseScalar(literal)) {
+            return false;
+        }
+
+        // Integers are the common case; anything else goes through strtod
+        // from a small stack copy, keeping only integral values like Qt does
+        value = 0;
+        size_t i = literal[0] == '-' ? 1 : 0;
+        qint64 number = 0;
+        for (; i < literal.size() && isdigit(uchar(literal[i])) && number <= INT_MAX; ++i) {
+            number = number * 10 + (literal[i] - '0');
+        }
+        if (i == literal.size()) {
+            value = int(qBound<qint64>(INT_MIN, literal[0] == '-' ? -number : number, INT_MAX));
+        } else if (literal.size() < 64) {
+            char text[64];
+            memcpy(text, literal.data(), literal.size());
+            text[literal.size()] = '\0';
+            char *end = nullptr;
+            double real = strtod(text, &end);
+            if (end == text + literal.size() && std::trunc(real) == real && std::fabs(real) <= INT_MAX) {
+                value = int(real);
+            }
+        }
+        return true;
+    }
+
+    // Decodes the string in place; escapes never grow the text
+    bool parseString(std::string_view &value)
+    {
+        ++m_pos; // opening quote
+        char *start = m_pos;
+        char *out = m_pos;
+        while (m_pos < m_end) {
+            char c = *m_pos++;
+            if (c == '"') {
+                value = std::string_view(start, size_t(out - start));
+                return true;
+            }
+            if (c != '\\') {
+                *out++ = c;
+                continue;
+            }
+            if (m_pos >= m_end) {
+                return false;
+            }
+            c = *m_pos++;
+            switch (c) {
+            case '"': *out++ = '"'; break;
+            case '\\': *out++ = '\\'; break;
+            case '/': *out++ = '/'; break;
+            case 'b': *out++ = '\b'; break;
+            case 'f': *out++ = '\f'; break;
+            case 'n': *out++ = '\n'; break;
+            case 'r': *out++ = '\r'; break;
+            case 't': *out++ = '\t'; break;
+            case 'u': {
+                uint code;
+                if (!parseHex(code)) {
+                    return false;
+                }
+                if (code >= 0xd800 && code < 0xdc00 && m_end - m_pos >= 6
+                        && m_pos[0] == '\\' && m_pos[1] == 'u') {
+                    m_pos += 2;
+                    uint low;
+                    if (!parseHex(low) || low < 0xdc00 || low >= 0xe000) {
+                        return false;
+                    }
+                    code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+                }
+                out = appendUtf8(out, code);
+                break;
+            }
+            default:
+                return false;
+            }
+        }
+        return false;
+    }
+
+    bool parseHex(uint &code)
+    {
+        if (m_end - m_pos < 4) {
+            return false;
+        }
+        code = 0;
+        for (int i = 0; i < 4; ++i) {
+            char c = *m_pos++;
+            code <<= 4;
+            if (c >= '0' && c <= '9') {
+                code |= uint(c - '0');
+            } else if (c >= 'a' && c <= 'f') {
+                code |= uint(c - 'a' + 10);
+            } else if (c >= 'A' && c <= 'F') {
+                code |= uint(c - 'A' + 10);
+            } else {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static char *appendUtf8(char *out, uint code)
+    {
+        if (code < 0x80) {
+            *out++ = char(code);
+        } else if (code < 0x800) {
+            *out++ = char(0xc0 | (code >> 6));
+            *out++ = char(0x80 | (code & 0x3f));
+        } else if (code < 0x10000) {
+            *out++ = char(0xe0 | (code >> 12));
+            *out++ = char(0x80 | ((code >> 6) & 0x3f));
+            *out++ = char(0x80 | (code & 0x3f));
+        } else {
+            *out++ = char(0xf0 | (code >> 18));
+            *out++ = char(0x80 | ((code >> 12) & 0x3f));
+            *out++ = char(0x80 | ((code >> 6) & 0x3f));
+            *out++ = char(0x80 | (code & 0x3f));
+        }
+        return out;
+    }
+
+    bool skipValue(int depth)
+    {
+        if (depth > MaxDepth) {
+            return false;
+        }
+        std::string_view ignored;
+        switch (peek()) {
+        case '{':
+            return parseObject([&](std::string_view) { return skipValue(depth + 1); });
+        case '[':
+            ++m_pos;
+            skipWhitespace();
+            if (peek() == ']') {
+                ++m_pos;
+                return true;
+            }
+            while (true) {
+                if (!skipValue(depth + 1)) {
+                    return false;
+                }
+                skipWhitespace();
+                if (peek() == ',') {
+                    ++m_pos;
+                    skipWhitespace();
+                } else if (peek() == ']') {
+                    ++m_pos;
+                    return true;
+                } else {
+                    return false;
+                }
+            }
+        default:
+            return parseScalar(ignored);
+        }
+    }
+
+    void skipWhitespace()
+    {
+        while (m_pos < m_end && (*m_pos == ' ' || *m_pos == '\n' || *m_pos == '\r' || *m_pos == '\t')) {
+            ++m_pos;
+        }
+    }
+
+    char peek() const { return m_pos < m_end ? *m_pos : '\0'; }
+
+    char *m_pos;
+    char *m_end;
+    std::string_view m_cbor;
+};
+
+// Walks a CBOR payload with integer keys, see PushCbor. Strings are
+// copied and integers printed into the text buffer [out, outEnd), which
+// the caller sizes so it cannot run out for a valid payload.
+class CborScanner
+{
+public:
+    CborScanner(const char *data, int size, char *out, char *outEnd)
+        : m_reader(data, size), m_size(size), m_out(out), m_outEnd(outEnd) {}
+
+    bool parsePayload(PushMessage &message)
+    {
+        // An optional self-describe tag (55799) comes first
+        if (m_reader.isTag() && !m_reader.next()) {
+            return false;
+        }
+        bool ok = parseMap([&](quint64 key) {
+            switch (key) {
+            case PushCbor::Message:
+                return m_reader.isMap() ? parseEvent(message) : m_reader.next();
+            case PushCbor::Messages:
+                return parseEvents(message);
+            case PushCbor::ExpireOn:
+                return parseScalar(message.expireOn);
+            }
+            return m_reader.next();
+        });
+        return ok && m_reader.lastError() == QCborError::NoError && m_reader.currentOffset() == m_size;
+    }
+
+private:
+    // The first event fills the message itself, later ones go to more
+    bool parseEvent(PushMessage &message)
+    {
+        if (!message.hasMessage) {
+            message.hasMessage = true;
+            return parseMessage(message);
+        }
+        message.more.append(PushEvent());
+        return parseMessage(message.more.last());
+    }
+
+    bool parseEvents(PushMessage &message)
+    {
+        return parseArray([&]() {
+            return m_reader.isMap() ? parseEvent(message) : m_reader.next();
+        });
+    }
+
+    bool parseMessage(PushEvent &message)
+    {
+        return parseMap([&](quint64 key) {
+            switch (key) {
+            case PushCbor::LocKey:
+                return parseScalar(message.locKey);
+            case PushCbor::LocArgs:
+                return parseLocArgs(message);
+            case PushCbor::Badge:
+                return parseInt(message.badge);
+            case PushCbor::Custom:
+                return parseCustom(message);
+            case PushCbor::Date:
+                return parseScalar(message.date);
+            }
+            return m_reader.next();
+        });
+    }
+
+    bool parseLocArgs(PushEvent &message)
+    {
+        message.locArgCount = 0;
+        return parseArray([&]() {
+            // Like the JSON path, non-string arguments read as empty
+            std::string_view arg;
+            if (!(m_reader.isString() ? parseScalar(arg) : m_reader.next())) {
+                return false;
+            }
+            if (message.locArgCount < PushEvent::MaxLocArgs) {
+                message.locArgs[message.locArgCount++] = arg;
+            }
+            return true;
+        });
+    }
+
+    bool parseCustom(PushEvent &message)
+    {
+        return parseMap([&](quint64 key) {
+            switch (key) {
+            case PushCbor::FromId:
+                return parseScalar(message.fromId);
+            case PushCbor::ChatId:
+                return parseScalar(message.chatId);
+            case PushCbor::ChannelId:
+                return parseScalar(message.channelId);
+            case PushCbor::Id:
+                return parseScalar(message.id);
+            }
+            return m_reader.next();
+        });
+    }
+
+    // Calls handler(key) with the reader on each value of an integer-keyed
+    // map; anything but a map is skipped
+    template <typename Handler>
+    bool parseMap(Handler handler)
+    {
+        if (!m_reader.isMap()) {
+            return m_reader.next();
+        }
+        if (!m_reader.enterContainer()) {
+            return false;
+        }
+        while (m_reader.lastError() == QCborError::NoError && m_reader.hasNext()) {
+            quint64 key = m_reader.isUnsignedInteger() ? m_reader.toUnsignedInteger() : quint64(-1);
+            if (!m_reader.next() || !handler(key)) {
+                return false;
+            }
+        }
+        return m_reader.lastError() == QCborError::NoError && m_reader.leaveContainer();
+    }
+
+    // Calls handler() with the reader on each element of an array;
+    // anything but an array is skipped
+    template <typename Handler>
+    bool parseArray(Handler handler)
+    {
+        if (!m_reader.isArray()) {
+            return m_reader.next();
+        }
+        if (!m_reader.enterContainer()) {
+            return false;
+        }
+        while (m_reader.lastError() == QCborError::NoError && m_reader.hasNext()) {
+            if (!handler()) {
+                return false;
+            }
+        }
+        return m_reader.lastError() == QCborError::NoError && m_reader.leaveContainer();
+    }
+
+    // Text strings yield their text, integers their decimal text; other
+    // values are skipped and leave value null
+    bool parseScalar(std::string_view &value)
+    {
+        char *start = m_out;
+        if (m_reader.isString()) {
+            auto chunk = m_reader.readStringChunk(m_out, m_outEnd - m_out);
+            while (chunk.status == QCborStreamReader::Ok) {
+                m_out += chunk.data;
+                chunk = m_reader.readStringChunk(m_out, m_outEnd - m_out);
+            }
+            if (chunk.status == QCborStreamReader::Error) {
+                return false;
+            }
+            value = std::string_view(start, size_t(m_out - start));
+            return true;
+        }
+
+        std::to_chars_result printed;
+        if (m_reader.isUnsignedInteger()) {
+            printed = std::to_chars(m_out, m_outEnd, m_reader.toUnsignedInteger());
+        } else if (m_reader.isNegativeInteger()) {
+            printed = std::to_chars(m_out, m_outEnd, m_reader.toInteger());
+        } else {
+            return m_reader.next();
+        }
+        if (printed.ec != std::errc()) {
+            return false;
+        }
+        m_out = printed.ptr;
+        value = std::string_view(start, size_t(m_out - start));
+        return m_reader.next();
+    }
+
+    bool parseInt(int &value)
+    {
+        // Matches the JSON path: non-integers count as zero
+        value = 0;
+        if (m_reader.isInteger()) {
+            value = int(qBound<qint64>(INT_MIN, m_reader.toInteger(), INT_MAX));
+        }
+        return m_reader.next();
+    }
+
+    QCborStreamReader m_reader;
+    qint64 m_size;
+    char *m_out;
+    char *m_outEnd;
+};
+
+} // namespace
+
+bool PushMessage::readFile(const QString &filename)
+{
+    // File read and JSON parse are traced as separate stages
+    if (!readBuffer(filename))
+    {
+        return false;
+    }
+
+    return decode(m_buffer);
+}
+
+bool PushMessage::readBuffer(const QString &filename)
+{
+    TRACE_SCOPE("PushMessage::readFile");
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        qCWarning(pushMessage) << "Cannot open input file:" << filename;
+        return false;
+    }
+
+    // Size the buffer once; fall back to readAll() for pipes and the like
+    qint64 size = file.size();
+    if (size > 0)
+    {
+        m_buffer.resize(int(size));
+        if (file.read(m_buffer.data(), size) != size)
+        {
+            qCWarning(pushMessage) << "Short read from input file:" << filename;
+            return false;
+        }
+    }
+    else
+    {
+        m_buffer = file.readAll();
+    }
+
+    return true;
+}
+
+bool PushMessage::decode(const QByteArray &data)
+{
+    // Strings are unescaped in place, so we need our own copy of the bytes.
+    // When called from readFile() we already hold the only reference.
+    TRACE_SCOPE("PushMessage::decode");
+    QByteArray buffer = data;
+    *this = PushMessage{};
+    m_buffer = std::move(buffer);
+
+    // JSON starts with '{' or whitespace; a CBOR map starts with a byte in
+    // 0xa0..0xbf, or with the 0xd9 of a self-describe tag
+    uchar first = m_buffer.isEmpty() ? 0 : uchar(m_buffer.at(0));
+    if ((first >= 0xa0 && first <= 0xbf) || first == 0xd9)
+    {
+        return decodeCbor(m_buffer.constData(), m_buffer.size());
+    }
+
+    char *begin = m_buffer.data();
+    JsonScanner scanner(begin, begin + m_buffer.size());
+    if (!scanner.parsePayload(*this))
+    {
+        qCWarning(pushMessage) << "Malformed push payload";
+        return false;
+    }
+
+    // The push service only carries JSON, so CBOR arrives base64-encoded
+    // in a "cbor" member; other top-level members such as expire_on stay
+    if (scanner.cbor().data())
+    {
+        QByteArray packed = QByteArray::fromBase64(QByteArray::fromRawData(scanner.cbor().data(),
+                                                                           int(scanner.cbor().size())));
+        return decodeCbor(packed.constData(), packed.size());
+    }
+
+    return true;
+}
+
+bool PushMessage::decodeCbor(const char *data, int size)
+{
+    // Decoded strings never outgrow their encoding, printed integers at
+    // most about double it; size the text buffer once so views stay valid
+    m_text.resize(size * 3 + 32);
+    char *out = m_text.data();
+    CborScanner scanner(data, size, out, out + m_text.size());
+    if (!scanner.parsePayload(*this))
+    {
+        qCWarning(pushMessage) << "Malformed CBOR push payload";
+        return false;
+    }
+
+    return true;
+}
+
+QString PushEvent::locArg(int index) const
+{
+    if (index < 0 || index >= locArgCount)
+    {
+        return QString();
+    }
+    return toString(locArgs[index]);
+}
+
+qint64 PushMessage::expiresAtMs() const
+{
+    if (expireOn.empty())
+    {
+        return -1;
+    }
+
+    // CBOR payloads carry Unix seconds
+    qint64 seconds = toLongLong(expireOn);
+    if (seconds > 0)
+    {
+        return seconds * 1000;
+    }
+
+    // Only messages that carry an expiry pay for the date parser
+    QDateTime expires = QDateTime::fromString(toString(expireOn), Qt::ISODate);
+    return expires.isValid() ? expires.toMSecsSinceEpoch() : -1;
+}
+
+qint64 PushEvent::sentAtMs() const
+{
+    qint64 seconds = toLongLong(date);
+    return seconds > 0 ? seconds * 1000 : -1;
+}
+
+QString PushEvent::toString(std::string_view value)
+{
+    return QString::fromUtf8(value.data(), int(value.size()));
+}
+
+qint64 PushEvent::toLongLong(std::string_view value)
+{
+    // Same contract as QString::toLongLong(): anything but a plain
+    // decimal integer yields 0
+    size_t i = !value.empty() && (value[0] == '-' || value[0] == '+') ? 1 : 0;
+    if (i == value.size())
+    {
+        return 0;
+    }
+
+    quint64 number = 0;
+    for (; i < value.size(); ++i)
+    {
+        if (!isdigit(uchar(value[i])) || number > (quint64(LLONG_MAX) - 9) / 10)
+        {
+            return 0;
+        }
+        number = number * 10 + quint64(value[i] - '0');
+    }
+
+    return value[0] == '-' ? -qint64(number) : qint64(number);
+}
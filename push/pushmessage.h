@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * PushMessage - Typed view of an incoming push payload
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+#include <string_view>
+
+// Integer keys of the compact CBOR payload. It has the same structure as
+// the JSON one; keys that are not listed are skipped. Chat ids, date and
+// expire_on are Unix integers there, and expire_on is in seconds.
+namespace PushCbor {
+enum PayloadKey { Message = 0, Messages = 1, ExpireOn = 2 };
+enum MessageKey { LocKey = 0, LocArgs = 1, Badge = 2, Custom = 3, Date = 4 };
+enum CustomKey { FromId = 0, ChatId = 1, ChannelId = 2, Id = 3 };
+}
+
+// One message event of a payload. Only the fields the helper uses are
+// extracted; strings point into the payload buffer of the PushMessage
+// they came from.
+struct PushEvent
+{
+    static const int MaxLocArgs = 8;
+
+    QString locArg(int index) const;
+    static QString toString(std::string_view value);
+    static qint64 toLongLong(std::string_view value);
+
+    // message.date as ms since the epoch, or -1 when it is missing
+    qint64 sentAtMs() const;
+
+    std::string_view locKey;
+    std::string_view locArgs[MaxLocArgs];
+    int locArgCount = 0;
+    int badge = 0;
+
+    // Chat identifiers from the "custom" object; a null view means the
+    // key was absent, numbers are kept as their literal text
+    std::string_view fromId;
+    std::string_view chatId;
+    std::string_view channelId;
+    std::string_view id;
+
+    // Unix seconds when the server sent the message
+    std::string_view date;
+};
+
+// A decoded payload. Strings are decoded in place and point into the
+// payload buffer, so decoding a single-message JSON payload costs a single
+// allocation for the file contents.
+//
+// decode() also accepts the compact CBOR form, either as raw bytes or
+// base64-encoded in the "cbor" member of a JSON object, which is how it
+// travels through the push service. Its strings are copied into a second
+// buffer and numbers are kept as decimal text, like in JSON.
+//
+// The payload carries either one "message" object or a "messages" array
+// of them. The first event fills the PushEvent fields of the message
+// itself, so single-message code keeps working unchanged; any further
+// events are kept in order in more.
+struct PushMessage : PushEvent
+{
+    bool readFile(const QString &filename);
+    bool decode(const QByteArray &data);
+
+    int eventCount() const { return hasMessage ? 1 + more.size() : 0; }
+    const PushEvent &event(int index) const
+    {
+        return index == 0 ? static_cast<const PushEvent &>(*this) : more.at(index - 1);
+    }
+
+    // expire_on as ms since the epoch, or -1 when it is missing or does
+    // not parse
+    qint64 expiresAtMs() const;
+
+    bool hasMessage = false;
+    QVector<PushEvent> more;
+
+    // Top-level "expire_on" (ISO 8601, as in the push envelope, or Unix
+    // seconds); it applies to every event
+    std::string_view expireOn;
+
+private:
+    bool readBuffer(const QString &filename);
+    bool decodeCbor(const char *data, int size);
+
+    QByteArray m_buffer;
+    QByteArray m_text;
+};
@@ -0,0 +1,434 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * HttpConnection implementation
+ */
+
+#include "httpconnection.h"
+
+#include <QSslSocket>
+#include <QTcpSocket>
+#include <QVarLengthArray>
+#include <QDebug>
+#include <QLoggingCategory>
+
+#include <cerrno>
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+Q_LOGGING_CATEGORY(httpConnection, "pushSender.http")
+
+static const int DEFAULT_TIMEOUT_MS = 30000;
+
+// Linux's UIO_MAXIOV
+static const int MAX_IOVECS = 1024;
+
+HttpConnection::HttpConnection(const QUrl &server, QObject *parent)
+    : QObject(parent), m_server(server)
+{
+    m_timeout.setSingleShot(true);
+    m_timeout.setInterval(DEFAULT_TIMEOUT_MS);
+    connect(&m_timeout, &QTimer::timeout, this, &HttpConnection::timedOut);
+}
+
+HttpConnection::~HttpConnection()
+{
+    // The socket aborts when it is deleted with us, and its disconnected()
+    // must not reach a half-destroyed connection
+    if (m_socket)
+    {
+        m_socket->disconnect(this);
+    }
+}
+
+void HttpConnection::send(quint64 id, const HttpRequest &request)
+{
+    if (!m_socket)
+    {
+        open();
+    }
+
+    if (m_pending.isEmpty())
+    {
+        m_timeout.start();
+    }
+    m_pending.enqueue(id);
+    m_outgoing.append(request);
+
+    if (!m_flushQueued)
+    {
+        m_flushQueued = true;
+        QMetaObject::invokeMethod(this, "flush", Qt::QueuedConnection);
+    }
+}
+
+void HttpConnection::flush()
+{
+    m_flushQueued = false;
+    if (!m_socket || m_outgoing.isEmpty())
+    {
+        return;
+    }
+
+    // connected() or encrypted() flushes again; until then the requests
+    // count as never written
+    if (m_socket->state() != QAbstractSocket::ConnectedState
+        || (m_tls && !static_cast<QSslSocket *>(m_socket)->isEncrypted()))
+    {
+        return;
+    }
+
+    // TLS has to encrypt into a buffer of its own anyway, so it gets the
+    // requests through QSslSocket
+    if (m_tls)
+    {
+        for (const HttpRequest &request : qAsConst(m_outgoing))
+        {
+            writeCopied(request, 0);
+        }
+        m_outgoing.clear();
+        return;
+    }
+
+    // Anything still in the socket's buffer has to go out first
+    if (m_socket->bytesToWrite() > 0)
+    {
+        for (const HttpRequest &request : qAsConst(m_outgoing))
+        {
+            writeCopied(request, 0);
+        }
+    }
+    else
+    {
+        writeGathered();
+    }
+    m_outgoing.clear();
+}
+
+void HttpConnection::writeGathered()
+{
+    const int fd = int(m_socket->socketDescriptor());
+
+    int next = 0;
+    while (next < m_outgoing.size())
+    {
+        QVarLengthArray<iovec, 3 * 64> iov;
+        qint64 total = 0;
+        int first = next;
+        while (next < m_outgoing.size() && iov.size() + 3 <= MAX_IOVECS)
+        {
+            const HttpRequest &request = m_outgoing.at(next++);
+            const char *own = request.own.constData();
+            iov.append({ const_cast<char *>(own), size_t(request.headSize) });
+            if (!request.shared.isEmpty())
+            {
+                iov.append({ const_cast<char *>(request.shared.constData()), size_t(request.shared.size()) });
+            }
+            if (request.own.size() > request.headSize)
+            {
+                iov.append({ const_cast<char *>(own + request.headSize),
+                             size_t(request.own.size() - request.headSize) });
+            }
+            total += request.size();
+        }
+
+        // sendmsg() rather than writev() for MSG_NOSIGNAL: a peer that went
+        // away must show up as a socket error, not SIGPIPE
+        msghdr message = {};
+        message.msg_iov = iov.data();
+        message.msg_iovlen = size_t(iov.size());
+        ssize_t written;
+        do
+        {
+            written = ::sendmsg(fd, &message, MSG_NOSIGNAL);
+        } while (written < 0 && errno == EINTR);
+
+        if (written == total)
+        {
+            continue;
+        }
+
+        // The kernel buffer is full (or the socket failed, which Qt will
+        // report); the rest waits in the socket's buffer
+        qint64 skip = qMax<qint64>(written, 0);
+        for (int i = first; i < m_outgoing.size(); ++i)
+        {
+            skip = writeCopied(m_outgoing.at(i), skip);
+        }
+        return;
+    }
+}
+
+qint64 HttpConnection::writeCopied(const HttpRequest &request, qint64 skip)
+{
+    const struct { const char *data; qint64 size; } parts[] = {
+        { request.own.constData(), request.headSize },
+        { request.shared.constData(), request.shared.size() },
+        { request.own.constData() + request.headSize, request.own.size() - request.headSize },
+    };
+
+    for (const auto &part : parts)
+    {
+        if (skip >= part.size)
+        {
+            skip -= part.size;
+            continue;
+        }
+        m_socket->write(part.data + skip, part.size - skip);
+        skip = 0;
+    }
+    return skip;
+}
+
+void HttpConnection::open()
+{
+    m_tls = m_server.scheme() == "https";
+    m_socket = m_tls ? new QSslSocket(this) : new QTcpSocket(this);
+    ++m_connects;
+
+    connect(m_socket, &QTcpSocket::readyRead, this, &HttpConnection::readResponses);
+    connect(m_socket, &QTcpSocket::disconnected, this, &HttpConnection::connectionLost);
+    connect(m_socket, QOverload<QAbstractSocket::SocketError>::of(&QAbstractSocket::error),
+            this, &HttpConnection::connectionLost);
+
+    // Pipelined requests are small; don't let Nagle hold them back. The
+    // options only stick once there is a socket descriptor.
+    QTcpSocket *socket = m_socket;
+    connect(m_socket, &QTcpSocket::connected, this, [this, socket]() {
+        socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        socket->setSocketOption(QAbstractSocket::KeepAliveOption, 1);
+        flush();
+    });
+
+    qCDebug(httpConnection) << "Connecting to" << m_server.host();
+    if (m_tls)
+    {
+        connect(static_cast<QSslSocket *>(m_socket), &QSslSocket::encrypted, this, &HttpConnection::flush);
+        static_cast<QSslSocket *>(m_socket)->connectToHostEncrypted(m_server.host(), quint16(m_server.port(443)));
+    }
+    else
+    {
+        m_socket->connectToHost(m_server.host(), quint16(m_server.port(80)));
+    }
+}
+
+void HttpConnection::reset()
+{
+    m_timeout.stop();
+    if (m_socket)
+    {
+        // We may be inside one of its signals
+        m_socket->disconnect(this);
+        m_socket->abort();
+        m_socket->deleteLater();
+        m_socket = nullptr;
+    }
+    m_outgoing.clear();
+    m_input.clear();
+    m_offset = 0;
+    m_response = Response();
+}
+
+void HttpConnection::fail(const QString &error)
+{
+    // Unflushed requests are the tail of m_pending
+    QVector<quint64> ids = m_pending.toVector();
+    int written = ids.size() - m_outgoing.size();
+    m_pending.clear();
+    reset();
+
+    if (!ids.isEmpty())
+    {
+        qCDebug(httpConnection) << "Connection lost with" << ids.size() << "requests unanswered," << written
+                                << "of them written:" << error;
+        emit failed(ids, written, error);
+    }
+}
+
+void HttpConnection::readResponses()
+{
+    m_input.append(m_socket->readAll());
+    if (m_pending.isEmpty())
+    {
+        // Nothing was asked; whatever this is, it is not ours
+        m_input.clear();
+        m_offset = 0;
+        return;
+    }
+    m_timeout.start();
+
+    QTcpSocket *socket = m_socket;
+    while (!m_pending.isEmpty() && m_socket == socket)
+    {
+        if (!m_response.headersDone && !parseHeaders())
+        {
+            break;
+        }
+        if (!parseBody())
+        {
+            break;
+        }
+
+        Response done = std::move(m_response);
+        m_response = Response();
+        quint64 id = m_pending.dequeue();
+
+        // Anything pipelined behind a closing response is lost, and the
+        // connection is reset before anyone can queue more on it
+        QVector<quint64> orphans;
+        int written = 0;
+        if (done.close)
+        {
+            orphans = m_pending.toVector();
+            written = orphans.size() - m_outgoing.size();
+            m_pending.clear();
+            reset();
+        }
+        else if (m_pending.isEmpty())
+        {
+            m_timeout.stop();
+        }
+
+        emit response(id, done.status, done.body);
+        if (!orphans.isEmpty())
+        {
+            emit failed(orphans, written, QStringLiteral("Server closed the connection"));
+        }
+        if (done.close)
+        {
+            return;
+        }
+    }
+
+    if (m_socket == socket)
+    {
+        m_input.remove(0, m_offset);
+        m_offset = 0;
+    }
+}
+
+bool HttpConnection::parseHeaders()
+{
+    int end = m_input.indexOf("\r\n\r\n", m_offset);
+    if (end < 0)
+    {
+        return false;
+    }
+
+    const QList<QByteArray> lines = m_input.mid(m_offset, end - m_offset).split('\n');
+    m_offset = end + 4;
+
+    // "HTTP/1.1 200 OK"; 1.0 servers close unless they say otherwise
+    const QByteArray statusLine = lines.first().trimmed();
+    m_response.status = statusLine.mid(9, 3).toInt();
+    m_response.close = statusLine.startsWith("HTTP/1.0");
+
+    for (int i = 1; i < lines.size(); ++i)
+    {
+        int colon = lines.at(i).indexOf(':');
+        if (colon < 0)
+        {
+            continue;
+        }
+        QByteArray name = lines.at(i).left(colon).trimmed().toLower();
+        QByteArray value = lines.at(i).mid(colon + 1).trimmed().toLower();
+        if (name == "content-length")
+        {
+            m_response.contentLength = value.toLongLong();
+        }
+        else if (name == "transfer-encoding")
+        {
+            m_response.chunked = value.contains("chunked");
+        }
+        else if (name == "connection")
+        {
+            m_response.close = value == "close";
+        }
+    }
+
+    if (m_response.status == 204 || m_response.status == 304)
+    {
+        m_response.contentLength = 0;
+    }
+    m_response.headersDone = true;
+    return true;
+}
+
+bool HttpConnection::parseBody()
+{
+    if (!m_response.chunked)
+    {
+        // Without a length the body runs to the end of the connection,
+        // which connectionLost() finishes
+        if (m_response.contentLength < 0 || m_input.size() - m_offset < m_response.contentLength)
+        {
+            return false;
+        }
+        m_response.body = m_input.mid(m_offset, int(m_response.contentLength));
+        m_offset += int(m_response.contentLength);
+        return true;
+    }
+
+    while (true)
+    {
+        int lineEnd = m_input.indexOf("\r\n", m_offset);
+        if (lineEnd < 0)
+        {
+            return false;
+        }
+
+        // Chunk extensions after ';' are ignored
+        bool ok = false;
+        int size = m_input.mid(m_offset, lineEnd - m_offset).split(';').first().trimmed().toInt(&ok, 16);
+        if (!ok || size < 0)
+        {
+            fail(QStringLiteral("Malformed chunked response"));
+            return false;
+        }
+
+        if (size == 0)
+        {
+            // Optional trailers, up to an empty line
+            int end = m_input.indexOf("\r\n\r\n", lineEnd);
+            if (end < 0)
+            {
+                return false;
+            }
+            m_offset = end + 4;
+            return true;
+        }
+
+        if (m_input.size() < lineEnd + 2 + size + 2)
+        {
+            return false;
+        }
+        m_response.body.append(m_input.constData() + lineEnd + 2, size);
+        m_offset = lineEnd + 2 + size + 2;
+    }
+}
+
+void HttpConnection::connectionLost()
+{
+    if (!m_socket)
+    {
+        return;
+    }
+
+    // A response without a length ends with the connection
+    if (!m_pending.isEmpty() && m_response.headersDone && !m_response.chunked && m_response.contentLength < 0)
+    {
+        m_input.append(m_socket->readAll());
+        m_response.contentLength = m_input.size() - m_offset;
+        m_response.close = true;
+        readResponses();
+        return;
+    }
+
+    fail(m_socket->errorString());
+}
+
+void HttpConnection::timedOut()
+{
+    fail(QStringLiteral("Timed out waiting for the push service"));
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * HttpConnection - One persistent HTTP/1.1 connection to the push service
+ * with pipelined requests
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QObject>
+#include <QQueue>
+#include <QTimer>
+#include <QUrl>
+#include <QVector>
+
+class QTcpSocket;
+
+// One request as it goes on the wire: its own head and tail around a body
+// part that may be shared with other requests, so a payload sent to many
+// devices is held once. own is the head followed by the tail.
+struct HttpRequest
+{
+    QByteArray own;
+    int headSize = 0;
+    QByteArray shared;
+
+    int size() const { return own.size() + shared.size(); }
+};
+
+class HttpConnection : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit HttpConnection(const QUrl &server, QObject *parent = nullptr);
+    ~HttpConnection();
+
+    // Queues a complete request behind any that are still unanswered;
+    // responses come back in the same order. Requests queued in one event
+    // loop pass go out together in a gather write, without copying them
+    // into the socket's buffer unless the kernel does not take them all.
+    // Connects first if there is no open connection.
+    void send(quint64 id, const HttpRequest &request);
+
+    // Requests written and not answered yet
+    int pending() const { return m_pending.size(); }
+
+    // Aborts the connection if the server stays silent this long with
+    // requests outstanding
+    void setTimeout(int ms) { m_timeout.setInterval(ms); }
+
+    // Number of TCP connections opened so far
+    int connectCount() const { return m_connects; }
+
+Q_SIGNALS:
+    void response(quint64 id, int status, const QByteArray &body);
+
+    // The connection broke with these requests unanswered, in the order
+    // they were sent. The first written of them were handed to the socket
+    // and may or may not have reached the server; the rest never were.
+    void failed(const QVector<quint64> &ids, int written, const QString &error);
+
+private Q_SLOTS:
+    void flush();
+    void readResponses();
+    void connectionLost();
+    void timedOut();
+
+private:
+    struct Response
+    {
+        bool headersDone = false;
+        int status = 0;
+        qint64 contentLength = -1;
+        bool chunked = false;
+        bool close = false;
+        QByteArray body;
+    };
+
+    void open();
+    void reset();
+    void writeGathered();
+    qint64 writeCopied(const HttpRequest &request, qint64 skip);
+    bool parseHeaders();
+    bool parseBody();
+    void fail(const QString &error);
+
+    QUrl m_server;
+    QTcpSocket *m_socket = nullptr;
+    bool m_tls = false;
+    QQueue<quint64> m_pending;
+    QVector<HttpRequest> m_outgoing;
+    bool m_flushQueued = false;
+    QTimer m_timeout;
+    int m_connects = 0;
+
+    // Unparsed input starts at m_offset; consumed bytes are dropped once
+    // per read rather than once per response
+    QByteArray m_input;
+    int m_offset = 0;
+    Response m_response;
+};
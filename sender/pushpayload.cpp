@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * PushPayload implementation
+ */
+
+#include "pushpayload.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+
+static QJsonObject message(const char *locKey, const QJsonArray &locArgs, int badge, const char *idKey,
+                           qint64 chatId)
+{
+    QJsonObject custom;
+    custom.insert(idKey, QString::number(chatId));
+
+    QJsonObject message;
+    message.insert("loc_key", locKey);
+    message.insert("loc_args", locArgs);
+    message.insert("badge", badge);
+    message.insert("date", QDateTime::currentSecsSinceEpoch());
+    message.insert("custom", custom);
+
+    QJsonObject data;
+    data.insert("message", message);
+    return data;
+}
+
+QJsonObject PushPayload::textMessage(const QString &sender, const QString &text, qint64 chatId, int badge)
+{
+    return message("MESSAGE_TEXT", QJsonArray { sender, text }, badge, "from_id", chatId);
+}
+
+QJsonObject PushPayload::photoMessage(const QString &sender, qint64 chatId, int badge)
+{
+    return message("MESSAGE_PHOTO", QJsonArray { sender }, badge, "from_id", chatId);
+}
+
+QJsonObject PushPayload::groupMessage(const QString &sender, const QString &group, const QString &text,
+                                      qint64 chatId, int badge)
+{
+    return message("CHAT_MESSAGE_TEXT", QJsonArray { sender, group, text }, badge, "chat_id", chatId);
+}
+
+QJsonObject PushPayload::groupInvite(const QString &sender, const QString &group, qint64 chatId, int badge)
+{
+    return message("CHAT_ADD_YOU", QJsonArray { sender, group }, badge, "chat_id", chatId);
+}
+
+QJsonObject PushPayload::packed(const QVector<QJsonObject> &messages)
+{
+    QJsonArray events;
+    for (const QJsonObject &data : messages)
+    {
+        events.append(data.value("message"));
+    }
+
+    QJsonObject data;
+    data.insert("messages", events);
+    return data;
+}
+
+QByteArray PushRequest::envelope(const QString &appId) const
+{
+    return PushEnvelope(appId, data, clearPending, expireOn).body(token, replaceTag.toUtf8());
+}
+
+// Escaped length of a JSON string's contents
+static int jsonStringSize(const QByteArray &value)
+{
+    int size = value.size();
+    for (char c : value)
+    {
+        if (c == '"' || c == '\\')
+        {
+            size += 1;
+        }
+        else if (uchar(c) < 0x20)
+        {
+            size += 5;
+        }
+    }
+    return size;
+}
+
+static void appendJsonString(QByteArray &out, const QByteArray &value)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    out += '"';
+    for (char c : value)
+    {
+        if (c == '"' || c == '\\')
+        {
+            out += '\\';
+            out += c;
+        }
+        else if (uchar(c) < 0x20)
+        {
+            out += "\\u00";
+            out += hex[uchar(c) >> 4];
+            out += hex[uchar(c) & 0xf];
+        }
+        else
+        {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+static const char TAG_MEMBER[] = "\"replace_tag\":";
+static const char TOKEN_MEMBER[] = ",\"token\":";
+
+PushEnvelope::PushEnvelope(const QString &appId, const QJsonObject &data, bool clearPending,
+                           const QDateTime &expireOn)
+{
+    QDateTime expires = expireOn.isValid() ? expireOn : QDateTime::currentDateTimeUtc().addDays(1);
+    QString expireText = expires.toUTC().toString(Qt::ISODateWithMs);
+
+    QJsonObject payload = data;
+    payload.insert("expire_on", expireText);
+
+    QJsonObject envelope;
+    envelope.insert("appid", appId);
+    envelope.insert("expire_on", expireText);
+    envelope.insert("clear_pending", clearPending);
+    envelope.insert("data", payload);
+
+    // Reopen the object for the per-device members
+    m_shared = QJsonDocument(envelope).toJson(QJsonDocument::Compact);
+    m_shared.chop(1);
+    m_shared += ',';
+}
+
+int PushEnvelope::tailSize(const QByteArray &token, const QByteArray &replaceTag) const
+{
+    int size = int(sizeof(TAG_MEMBER) - 1) + int(sizeof(TOKEN_MEMBER) - 1) + jsonStringSize(token) + 3;
+    size += replaceTag.isEmpty() ? 4 : jsonStringSize(replaceTag) + 2;
+    return size;
+}
+
+void PushEnvelope::appendTail(QByteArray &out, const QByteArray &token, const QByteArray &replaceTag) const
+{
+    out += TAG_MEMBER;
+    if (replaceTag.isEmpty())
+    {
+        out += "null";
+    }
+    else
+    {
+        appendJsonString(out, replaceTag);
+    }
+    out += TOKEN_MEMBER;
+    appendJsonString(out, token);
+    out += '}';
+}
+
+QByteArray PushEnvelope::body(const QByteArray &token, const QByteArray &replaceTag) const
+{
+    QByteArray body;
+    body.reserve(m_shared.size() + tailSize(token, replaceTag));
+    body += m_shared;
+    appendTail(body, token, replaceTag);
+    return body;
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * PushPayload - Push message payloads and the push service envelope, in
+ * the shapes server-example.py sends
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QJsonObject>
+#include <QString>
+#include <QVector>
+
+// The "data" a push helper receives, one function per create_*() helper
+// in server-example.py
+namespace PushPayload {
+
+QJsonObject textMessage(const QString &sender, const QString &message, qint64 chatId, int badge = 1);
+QJsonObject photoMessage(const QString &sender, qint64 chatId, int badge = 1);
+QJsonObject groupMessage(const QString &sender, const QString &group, const QString &message, qint64 chatId,
+                         int badge = 1);
+QJsonObject groupInvite(const QString &sender, const QString &group, qint64 chatId, int badge = 1);
+
+// Several of the above as one push, like pack_messages()
+QJsonObject packed(const QVector<QJsonObject> &messages);
+
+}
+
+// One notification for one device
+struct PushRequest
+{
+    QByteArray token;
+    QJsonObject data;
+    QString replaceTag;
+    bool clearPending = true;
+
+    // 24 hours from now when not set
+    QDateTime expireOn;
+
+    // The JSON body POSTed to the push service. expire_on is repeated in
+    // the data so the helper can drop messages that expired offline.
+    QByteArray envelope(const QString &appId) const;
+};
+
+// The envelope of one message for any number of devices. Everything but
+// replace_tag and token is serialized once, up front; a device's body is
+// shared() followed by its tail, so sending to another device costs only
+// the tail.
+class PushEnvelope
+{
+public:
+    PushEnvelope(const QString &appId, const QJsonObject &data, bool clearPending = true,
+                 const QDateTime &expireOn = QDateTime());
+
+    // Everything up to the per-device members, identical for every device
+    const QByteArray &shared() const { return m_shared; }
+
+    // Size of the tail for this device, so callers can size its buffer;
+    // replaceTag is UTF-8 and may be empty for none
+    int tailSize(const QByteArray &token, const QByteArray &replaceTag) const;
+    void appendTail(QByteArray &out, const QByteArray &token, const QByteArray &replaceTag) const;
+
+    // The whole body for one device
+    QByteArray body(const QByteArray &token, const QByteArray &replaceTag) const;
+
+private:
+    QByteArray m_shared;
+};
@@ -0,0 +1,226 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * PushSender implementation
+ */
+
+#include "pushsender.h"
+#include "httpconnection.h"
+
+#include <QRandomGenerator>
+#include <QTimer>
+#include <QDebug>
+#include <QLoggingCategory>
+
+Q_LOGGING_CATEGORY(pushSender, "pushSender")
+
+PushSender::PushSender(const QUrl &url, const QString &appId, QObject *parent)
+    : QObject(parent), m_url(url), m_appId(appId)
+{
+}
+
+void PushSender::setBackoff(int baseMs, int maxMs)
+{
+    m_backoffBaseMs = qMax(1, baseMs);
+    m_backoffMaxMs = qMax(m_backoffBaseMs, maxMs);
+}
+
+PushSenderStats PushSender::stats() const
+{
+    PushSenderStats stats = m_stats;
+    for (const HttpConnection *connection : m_connections)
+    {
+        stats.connects += connection->connectCount();
+    }
+    return stats;
+}
+
+void PushSender::send(const PushRequest &request)
+{
+    send(PushEnvelope(m_appId, request.data, request.clearPending, request.expireOn), request.token,
+         request.replaceTag.toUtf8());
+}
+
+void PushSender::send(const PushEnvelope &envelope, const QByteArray &token, const QByteArray &replaceTag)
+{
+    const QByteArray &prefix = head();
+    int tailSize = envelope.tailSize(token, replaceTag);
+    QByteArray length = QByteArray::number(envelope.shared().size() + tailSize);
+
+    // Head and tail share one exactly sized buffer; the envelope's bytes
+    // are only referenced
+    Job job;
+    job.token = token;
+    job.replaceable = !replaceTag.isEmpty();
+    job.request.shared = envelope.shared();
+    job.request.own.reserve(prefix.size() + length.size() + 4 + tailSize);
+    job.request.own += prefix;
+    job.request.own += length;
+    job.request.own += "\r\n\r\n";
+    job.request.headSize = job.request.own.size();
+    envelope.appendTail(job.request.own, token, replaceTag);
+
+    m_queue.enqueue(std::move(job));
+    ++m_stats.sent;
+
+    dispatch();
+}
+
+// Everything before the Content-Length value, the same for every request
+const QByteArray &PushSender::head()
+{
+    if (!m_head.isEmpty())
+    {
+        return m_head;
+    }
+
+    QByteArray path = m_url.path(QUrl::FullyEncoded).toUtf8();
+    if (path.isEmpty())
+    {
+        path = "/";
+    }
+    if (m_url.hasQuery())
+    {
+        path += '?' + m_url.query(QUrl::FullyEncoded).toUtf8();
+    }
+
+    m_head += "POST " + path + " HTTP/1.1\r\n";
+    m_head += "Host: " + m_url.authority(QUrl::FullyEncoded).toUtf8() + "\r\n";
+    m_head += "Content-Type: application/json\r\n";
+    if (!m_authToken.isEmpty())
+    {
+        m_head += "Authorization: Bearer " + m_authToken + "\r\n";
+    }
+    if (!m_keepAlive)
+    {
+        m_head += "Connection: close\r\n";
+    }
+    m_head += "Content-Length: ";
+    return m_head;
+}
+
+void PushSender::dispatch()
+{
+    while (!m_queue.isEmpty() && m_inFlight.size() < m_maxInFlight)
+    {
+        HttpConnection *connection = leastBusy();
+        if (!connection)
+        {
+            break;
+        }
+
+        quint64 id = m_nextId++;
+        auto it = m_inFlight.insert(id, m_queue.dequeue());
+        connection->send(id, it->request);
+    }
+}
+
+HttpConnection *PushSender::leastBusy()
+{
+    // Without keep-alive the server closes after every answer, so anything
+    // pipelined behind the first request would only be lost
+    int depth = m_keepAlive ? m_pipelineDepth : 1;
+
+    HttpConnection *best = nullptr;
+    for (HttpConnection *connection : qAsConst(m_connections))
+    {
+        if (!best || connection->pending() < best->pending())
+        {
+            best = connection;
+        }
+    }
+
+    // Open another connection only once every open one has work
+    if ((!best || best->pending() > 0) && m_connections.size() < m_connectionCount)
+    {
+        best = new HttpConnection(m_url, this);
+        best->setTimeout(m_timeoutMs);
+        connect(best, &HttpConnection::response, this, &PushSender::onResponse);
+        connect(best, &HttpConnection::failed, this, &PushSender::onFailed);
+        m_connections.append(best);
+    }
+
+    return best && best->pending() < depth ? best : nullptr;
+}
+
+void PushSender::onResponse(quint64 id, int status, const QByteArray &body)
+{
+    Job job = m_inFlight.take(id);
+
+    if (status / 100 == 2)
+    {
+        ++m_stats.delivered;
+        emit delivered(job.token);
+    }
+    else if (status == 429 || status / 100 == 5)
+    {
+        retry(std::move(job), status, body);
+    }
+    else
+    {
+        qCDebug(pushSender) << "Push service refused" << job.token.left(10) << ":" << status << body;
+        ++m_stats.failed;
+        emit failed(job.token, status, body);
+    }
+
+    dispatch();
+    finish();
+}
+
+void PushSender::onFailed(const QVector<quint64> &ids, int written, const QString &error)
+{
+    // The service may have seen the written ones already. Sent again with
+    // the same replace_tag they still show once; without one the device
+    // could show them twice, so they are reported instead.
+    for (int i = 0; i < ids.size(); ++i)
+    {
+        Job job = m_inFlight.take(ids.at(i));
+        if (i < written && !job.replaceable)
+        {
+            qCWarning(pushSender) << "Not resending" << job.token.left(10) << "without a replace_tag:" << error;
+            ++m_stats.failed;
+            emit failed(job.token, 0, error.toUtf8());
+        }
+        else
+        {
+            retry(std::move(job), 0, error.toUtf8());
+        }
+    }
+
+    dispatch();
+    finish();
+}
+
+void PushSender::retry(Job job, int status, const QByteArray &body)
+{
+    if (job.attempt >= m_maxRetries)
+    {
+        qCWarning(pushSender) << "Giving up on" << job.token.left(10) << "after" << job.attempt + 1
+                              << "attempts:" << status << body;
+        ++m_stats.failed;
+        emit failed(job.token, status, body);
+        return;
+    }
+
+    // Full jitter: a uniform delay up to the exponential cap, so senders
+    // that failed together don't come back together
+    ++job.attempt;
+    int cap = int(qMin<qint64>(m_backoffMaxMs, qint64(m_backoffBaseMs) << qMin(job.attempt - 1, 20)));
+    int delay = QRandomGenerator::global()->bounded(cap + 1);
+
+    ++m_stats.retries;
+    ++m_retrying;
+    QTimer::singleShot(delay, this, [this, job]() {
+        --m_retrying;
+        m_queue.enqueue(job);
+        dispatch();
+    });
+}
+
+void PushSender::finish()
+{
+    if (pendingCount() == 0)
+    {
+        emit idle();
+    }
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * PushSender - Sends push notifications to the push service over a pool
+ * of keep-alive connections
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QObject>
+#include <QQueue>
+#include <QString>
+#include <QUrl>
+#include <QVector>
+
+#include "httpconnection.h"
+#include "pushpayload.h"
+
+struct PushSenderStats
+{
+    qint64 sent = 0;
+    qint64 delivered = 0;
+    qint64 failed = 0;
+    qint64 retries = 0;
+    int connects = 0;
+};
+
+// Requests are queued by send() and written to the least busy connection,
+// up to pipelineDepth unanswered requests per connection and maxInFlight
+// overall. 429 and 5xx answers are retried after a jittered exponential
+// backoff, and so are requests lost with a connection if they were never
+// written or carry a replace_tag; any other answer is final.
+class PushSender : public QObject
+{
+    Q_OBJECT
+
+public:
+    // url is the push service's /notify endpoint
+    PushSender(const QUrl &url, const QString &appId, QObject *parent = nullptr);
+
+    void setConnections(int connections) { m_connectionCount = qMax(1, connections); }
+    void setPipelineDepth(int depth) { m_pipelineDepth = qMax(1, depth); }
+    void setMaxInFlight(int maxInFlight) { m_maxInFlight = qMax(1, maxInFlight); }
+    void setMaxRetries(int retries) { m_maxRetries = qMax(0, retries); }
+    void setBackoff(int baseMs, int maxMs);
+    void setTimeout(int ms) { m_timeoutMs = ms; }
+
+    // Off sends "Connection: close" and opens a connection per request,
+    // the way server-example.py does
+    void setKeepAlive(bool keepAlive) { m_keepAlive = keepAlive; m_head.clear(); }
+
+    // Sent as a bearer token when set
+    void setAuthToken(const QString &token) { m_authToken = token.toUtf8(); m_head.clear(); }
+
+    void send(const PushRequest &request);
+
+    // For one message to many devices: the envelope is serialized once and
+    // every request shares its bytes, only replace_tag and token are
+    // written per device. replaceTag is UTF-8.
+    void send(const PushEnvelope &envelope, const QByteArray &token, const QByteArray &replaceTag = QByteArray());
+
+    // Queued, in flight or waiting to be retried
+    int pendingCount() const { return m_queue.size() + m_inFlight.size() + m_retrying; }
+
+    PushSenderStats stats() const;
+
+Q_SIGNALS:
+    void delivered(const QByteArray &token);
+
+    // status is 0 when the request never got an answer
+    void failed(const QByteArray &token, int status, const QByteArray &body);
+
+    // Emitted when the last pending request is done
+    void idle();
+
+private:
+    struct Job
+    {
+        QByteArray token;
+        HttpRequest request;
+        int attempt = 0;
+
+        // A second copy of the request replaces the first on the device
+        bool replaceable = false;
+    };
+
+    const QByteArray &head();
+    void dispatch();
+    HttpConnection *leastBusy();
+    void onResponse(quint64 id, int status, const QByteArray &body);
+    void onFailed(const QVector<quint64> &ids, int written, const QString &error);
+    void retry(Job job, int status, const QByteArray &body);
+    void finish();
+
+    QUrl m_url;
+    QString m_appId;
+    QByteArray m_authToken;
+    QByteArray m_head;
+    int m_connectionCount = 4;
+    int m_pipelineDepth = 16;
+    int m_maxInFlight = 64;
+    int m_maxRetries = 5;
+    int m_backoffBaseMs = 100;
+    int m_backoffMaxMs = 10000;
+    int m_timeoutMs = 30000;
+    bool m_keepAlive = true;
+
+    QVector<HttpConnection *> m_connections;
+    QQueue<Job> m_queue;
+    QHash<quint64, Job> m_inFlight;
+    int m_retrying = 0;
+    quint64 m_nextId = 1;
+    PushSenderStats m_stats;
+};
@@ -0,0 +1,259 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * push-sender - Sends push notifications to one or more devices, given
+ * directly or as users in a token registry; the native counterpart of
+ * server-example.py for sending at volume
+ */
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTextStream>
+
+#include <utility>
+#include <vector>
+
+#include "pushpayload.h"
+#include "pushsender.h"
+#include "tokenregistry.h"
+
+static const char DEFAULT_URL[] = "https://push.lomiri.com/notify";
+
+static QStringList readTokens(const QCommandLineParser &parser)
+{
+    QStringList tokens = parser.values("token");
+    if (parser.isSet("tokens-file"))
+    {
+        QFile file(parser.value("tokens-file"));
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        {
+            qFatal("Cannot read %s", qPrintable(file.fileName()));
+        }
+        while (!file.atEnd())
+        {
+            QString token = QString::fromUtf8(file.readLine()).trimmed();
+            if (!token.isEmpty())
+            {
+                tokens.append(token);
+            }
+        }
+    }
+    return tokens;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("push-sender");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Send Ubuntu Touch push notifications");
+    parser.addHelpOption();
+    parser.addOptions({
+        { "url", "Push service notify endpoint", "url", DEFAULT_URL },
+        { "app-id", "Application ID", "id" },
+        { "token", "Device push token; may be repeated", "token" },
+        { "tokens-file", "File with one device token per line", "file" },
+        { "auth", "Authorization token for push service", "token" },
+        { "type", "Message type: text, photo, group or invite", "type", "text" },
+        { "sender", "Sender name", "name", "Test Sender" },
+        { "message", "Message content", "text", "Hello from server!" },
+        { "group", "Group name (for group messages)", "name" },
+        { "chat-id", "Chat ID", "id", "123456789" },
+        { "badge", "Badge count", "count", "1" },
+        { "demo", "Send the sample messages" },
+        { "packed", "Send the demo messages as one push" },
+        { "count", "Send each message this many times per device", "n", "1" },
+        { "connections", "Keep-alive connections to the push service", "n", "4" },
+        { "pipeline", "Unanswered requests per connection", "n", "16" },
+        { "in-flight", "Unanswered requests overall", "n", "64" },
+        { "retries", "Retries after 429, 5xx or a lost connection", "n", "5" },
+        { "no-keep-alive", "Open a connection per request" },
+        { "registry", "Token registry snapshot to read and update", "file" },
+        { "user", "Send to this user's tokens from the registry; may be repeated", "id" },
+        { "add-token", "Register a token for a user in the registry; may be repeated", "user:token" },
+    });
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    // Tokens given directly, then those of the requested users
+    QVector<QByteArray> deviceTokens;
+    for (const QString &token : readTokens(parser))
+    {
+        deviceTokens.append(token.toUtf8());
+    }
+
+    TokenRegistry registry;
+    QString registryPath = parser.value("registry");
+    if (!registryPath.isEmpty() && QFile::exists(registryPath) && !registry.load(registryPath))
+    {
+        err << "Error: cannot load token registry " << registryPath << "\n";
+        return 2;
+    }
+    bool registryChanged = false;
+    for (const QString &entry : parser.values("add-token"))
+    {
+        int colon = entry.indexOf(':');
+        if (registryPath.isEmpty() || colon <= 0)
+        {
+            err << "Error: --add-token needs --registry and a user:token value\n";
+            return 2;
+        }
+        registryChanged |= registry.insert(entry.left(colon).toLongLong(), entry.mid(colon + 1).toUtf8());
+    }
+    for (const QString &user : parser.values("user"))
+    {
+        registry.lookup(user.toLongLong(), deviceTokens);
+    }
+
+    if (deviceTokens.isEmpty())
+    {
+        if (registryChanged)
+        {
+            return registry.save(registryPath) ? 0 : 1;
+        }
+        err << "Error: no device tokens; use --token, --tokens-file or --user with --registry\n";
+        return 2;
+    }
+
+    QString appId = parser.value("app-id");
+    if (appId.isEmpty())
+    {
+        err << "Error: --app-id is required\n";
+        return 2;
+    }
+
+    QString type = parser.value("type");
+    QString senderName = parser.value("sender");
+    QString text = parser.value("message");
+    QString group = parser.value("group");
+    qint64 chatId = parser.value("chat-id").toLongLong();
+    int badge = parser.value("badge").toInt();
+    if ((type == "group" || type == "invite") && group.isEmpty() && !parser.isSet("demo"))
+    {
+        err << "Error: --group is required for group messages and invites\n";
+        return 2;
+    }
+
+    // (data, replace_tag) pairs sent to every device
+    QVector<QPair<QJsonObject, QString>> messages;
+    qint64 now = QDateTime::currentSecsSinceEpoch();
+    if (parser.isSet("demo"))
+    {
+        QVector<QJsonObject> demo = {
+            PushPayload::textMessage("Alice", "Hey there! How are you?", 123456, 1),
+            PushPayload::photoMessage("Bob", 789012, 2),
+            PushPayload::groupMessage("Charlie", "My Friends", "Anyone up for coffee?", 345678, 3),
+            PushPayload::groupInvite("Dave", "Book Club", 901234, 4),
+        };
+        QString tag = QString("demo_%1").arg(now);
+        if (parser.isSet("packed"))
+        {
+            messages.append({ PushPayload::packed(demo), tag });
+        }
+        else
+        {
+            for (const QJsonObject &data : demo)
+            {
+                messages.append({ data, tag });
+            }
+        }
+    }
+    else
+    {
+        QJsonObject data;
+        if (type == "text")
+        {
+            data = PushPayload::textMessage(senderName, text, chatId, badge);
+        }
+        else if (type == "photo")
+        {
+            data = PushPayload::photoMessage(senderName, chatId, badge);
+        }
+        else if (type == "group")
+        {
+            data = PushPayload::groupMessage(senderName, group, text, chatId, badge);
+        }
+        else if (type == "invite")
+        {
+            data = PushPayload::groupInvite(senderName, group, chatId, badge);
+        }
+        else
+        {
+            err << "Error: unknown message type " << type << "\n";
+            return 2;
+        }
+        messages.append({ data, QString("msg_%1").arg(chatId) });
+    }
+
+    PushSender sender(QUrl(parser.value("url")), appId);
+    sender.setAuthToken(parser.value("auth"));
+    sender.setConnections(parser.value("connections").toInt());
+    sender.setPipelineDepth(parser.value("pipeline").toInt());
+    sender.setMaxInFlight(parser.value("in-flight").toInt());
+    sender.setMaxRetries(parser.value("retries").toInt());
+    sender.setKeepAlive(!parser.isSet("no-keep-alive"));
+
+    QObject::connect(&sender, &PushSender::failed, [&err](const QByteArray &token, int status,
+                                                        const QByteArray &body) {
+        err << "Failed " << token.left(10) << "...: "
+            << (status ? QString::number(status) : QString("no answer")) << " " << body << "\n";
+        err.flush();
+    });
+    QObject::connect(&sender, &PushSender::idle, &app, &QCoreApplication::quit);
+
+    // Tokens the service no longer knows are dropped from the registry
+    qint64 registeredTokens = registry.tokenCount();
+    registry.pruneFrom(&sender);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // Each message is serialized once for all devices
+    std::vector<std::pair<PushEnvelope, QByteArray>> envelopes;
+    for (const auto &message : qAsConst(messages))
+    {
+        envelopes.emplace_back(PushEnvelope(appId, message.first), message.second.toUtf8());
+    }
+    int count = qMax(1, parser.value("count").toInt());
+    for (int i = 0; i < count; ++i)
+    {
+        for (const QByteArray &token : qAsConst(deviceTokens))
+        {
+            for (const auto &envelope : envelopes)
+            {
+                sender.send(envelope.first, token, envelope.second);
+            }
+        }
+    }
+
+    if (sender.pendingCount() > 0)
+    {
+        app.exec();
+    }
+
+    PushSenderStats stats = sender.stats();
+    double seconds = qMax<qint64>(timer.elapsed(), 1) / 1000.0;
+    out << "Sent " << stats.sent << ", delivered " << stats.delivered << ", failed " << stats.failed
+        << ", retries " << stats.retries << ", connections " << stats.connects << " in "
+        << QString::number(seconds, 'f', 2) << "s (" << QString::number(stats.delivered / seconds, 'f', 0)
+        << "/s)\n";
+
+    qint64 pruned = registeredTokens - registry.tokenCount();
+    if (pruned > 0)
+    {
+        out << "Pruned " << pruned << " invalid tokens from the registry\n";
+    }
+    if ((registryChanged || pruned > 0) && !registry.save(registryPath))
+    {
+        err << "Error: cannot save token registry " << registryPath << "\n";
+        return 1;
+    }
+
+    return stats.failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,941 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * TokenRegistry implementation
+ */
+
+#include "tokenregistry.h"
+#include "pushsender.h"
+
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QDebug>
+#include <QLoggingCategory>
+
+#include <cstring>
+
+Q_LOGGING_CATEGORY(tokenRegistry, "pushSender.tokens")
+
+namespace {
+
+const char Magic[4] = { 'T', 'O', 'K', '1' };
+const quint32 MinCapacity = 16;
+const int MaxShards = 1 << 16;
+const int MaxTokenLength = 0xffff;
+
+// Keeps every arena within what QByteArray can hold
+const qint64 MaxArena = qint64(1) << 30;
+
+// Arena space no list points at is reclaimed once it is this large and
+// more than half the arena
+const quint32 CompactThreshold = 64 * 1024;
+
+struct Header
+{
+    char magic[4];
+    quint32 shardCount;
+    quint64 userCount;
+    quint64 tokenCount;
+};
+
+struct ShardHeader
+{
+    quint64 usersOffset;
+    quint64 tokensOffset;
+    quint64 arenaOffset;
+    quint32 userCapacity;
+    quint32 userCount;
+    quint32 tokenCapacity;
+    quint32 tokenCount;
+    quint32 arenaSize;
+    quint32 reserved;
+};
+
+// Empty when size is 0; a user whose last token goes is removed
+struct UserSlot
+{
+    qint64 user;
+    quint32 offset;
+    quint32 size;
+};
+
+// Empty when hash is 0
+struct TokenSlot
+{
+    quint64 hash;
+    qint64 user;
+};
+
+// splitmix64's finalizer: sequential user ids land on unrelated shards
+// and slots. The shard comes from the high bits, the slot from the low.
+inline quint64 mix(quint64 x)
+{
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+// FNV-1a, mixed. Token hashes are saved in snapshots, so unlike qHash
+// this must not change between processes.
+quint64 tokenHash(const char *data, int size)
+{
+    quint64 hash = 0xcbf29ce484222325ULL;
+    for (int i = 0; i < size; ++i)
+    {
+        hash = (hash ^ uchar(data[i])) * 0x100000001b3ULL;
+    }
+    hash = mix(hash);
+    return hash ? hash : 1;
+}
+
+inline quint64 home(const UserSlot &slot) { return mix(quint64(slot.user)); }
+inline quint64 home(const TokenSlot &slot) { return slot.hash; }
+inline bool isEmpty(const UserSlot &slot) { return slot.size == 0; }
+inline bool isEmpty(const TokenSlot &slot) { return slot.hash == 0; }
+
+inline quint64 align8(quint64 offset)
+{
+    return (offset + 7) & ~quint64(7);
+}
+
+inline bool isPowerOfTwo(quint32 value)
+{
+    return value && !(value & (value - 1));
+}
+
+// Smallest table that holds count slots within the 70% load factor
+quint32 capacityFor(quint32 count)
+{
+    quint64 capacity = MinCapacity;
+    while (quint64(count) * 10 > capacity * 7)
+    {
+        capacity *= 2;
+    }
+    return quint32(capacity);
+}
+
+// Linear probing deletion without tombstones: later slots of the cluster
+// move back into the hole unless that would put them before their home
+template<typename Slot>
+void eraseAt(Slot *slots, quint32 capacity, quint32 hole)
+{
+    quint32 mask = capacity - 1;
+    for (quint32 i = (hole + 1) & mask; !isEmpty(slots[i]); i = (i + 1) & mask)
+    {
+        quint32 k = quint32(home(slots[i])) & mask;
+        bool stays = hole <= i ? (hole < k && k <= i) : (hole < k || k <= i);
+        if (!stays)
+        {
+            slots[hole] = slots[i];
+            hole = i;
+        }
+    }
+    slots[hole] = Slot();
+}
+
+template<typename Slot>
+QVector<Slot> rehash(const Slot *slots, quint32 capacity, quint32 newCapacity)
+{
+    QVector<Slot> table(int(newCapacity));
+    Slot *out = table.data();
+    quint32 mask = newCapacity - 1;
+    for (quint32 i = 0; i < capacity; ++i)
+    {
+        if (isEmpty(slots[i]))
+        {
+            continue;
+        }
+        quint32 j = quint32(home(slots[i])) & mask;
+        while (!isEmpty(out[j]))
+        {
+            j = (j + 1) & mask;
+        }
+        out[j] = slots[i];
+    }
+    return table;
+}
+
+} // namespace
+
+struct TokenRegistry::Shard
+{
+    mutable QReadWriteLock lock;
+
+    // Into the snapshot mapping until the shard first changes, then into
+    // the containers below
+    const UserSlot *users = nullptr;
+    const TokenSlot *tokens = nullptr;
+    const char *arena = nullptr;
+    quint32 userCapacity = 0;
+    quint32 userCount = 0;
+    quint32 tokenCapacity = 0;
+    quint32 tokenCount = 0;
+    quint32 arenaSize = 0;
+    bool mapped = false;
+
+    QVector<UserSlot> ownUsers;
+    QVector<TokenSlot> ownTokens;
+    QByteArray ownArena;
+    quint32 garbage = 0;
+
+    int findUser(qint64 user) const
+    {
+        if (userCapacity == 0)
+        {
+            return -1;
+        }
+        // Bounded, since a mapped table is not trusted to have a hole
+        quint32 mask = userCapacity - 1;
+        quint32 i = quint32(mix(quint64(user))) & mask;
+        for (quint32 n = 0; n < userCapacity && !isEmpty(users[i]); ++n, i = (i + 1) & mask)
+        {
+            if (users[i].user == user)
+            {
+                return int(i);
+            }
+        }
+        return -1;
+    }
+
+    // Calls fn(entry, data, size) for each token of the list until it
+    // returns false. Lists in a mapped snapshot are bounds-checked here.
+    template<typename Fn>
+    void forEachToken(const UserSlot &slot, Fn fn) const
+    {
+        if (quint64(slot.offset) + slot.size > arenaSize)
+        {
+            return;
+        }
+        const char *p = arena + slot.offset;
+        const char *end = p + slot.size;
+        while (end - p >= 2)
+        {
+            const char *entry = p;
+            quint16 length;
+            memcpy(&length, p, sizeof(length));
+            p += sizeof(length);
+            if (length > end - p)
+            {
+                return;
+            }
+            if (length > 0 && !fn(entry, p, int(length)))
+            {
+                return;
+            }
+            p += length;
+        }
+    }
+
+    // Offset of token's entry in the user's list, or -1
+    qint64 findToken(const UserSlot &slot, const QByteArray &token) const
+    {
+        qint64 found = -1;
+        forEachToken(slot, [&](const char *entry, const char *data, int size) {
+            if (size == token.size() && memcmp(data, token.constData(), size_t(size)) == 0)
+            {
+                found = entry - arena;
+                return false;
+            }
+            return true;
+        });
+        return found;
+    }
+
+    void sync()
+    {
+        users = ownUsers.constData();
+        tokens = ownTokens.constData();
+        arena = ownArena.constData();
+        arenaSize = quint32(ownArena.size());
+    }
+
+    // Copies a mapped shard to the heap before its first change. load()
+    // only validates the shard table, so the slots are checked here: lists
+    // out of the arena and repeated users are dropped, and both tables are
+    // rebuilt at our load factor, so every probe below finds a hole. Slot
+    // indices and list offsets change.
+    void detach()
+    {
+        if (!mapped)
+        {
+            return;
+        }
+
+        QVector<UserSlot> mappedUsers;
+        quint64 live = 0;
+        for (quint32 i = 0; i < userCapacity; ++i)
+        {
+            const UserSlot &slot = users[i];
+            if (!isEmpty(slot) && quint64(slot.offset) + slot.size <= arenaSize)
+            {
+                mappedUsers.append(slot);
+                live += slot.size;
+            }
+        }
+        quint32 tokenSlots = 0;
+        for (quint32 i = 0; i < tokenCapacity; ++i)
+        {
+            tokenSlots += isEmpty(tokens[i]) ? 0 : 1;
+        }
+
+        QVector<UserSlot> newUsers(int(capacityFor(quint32(mappedUsers.size()))));
+        QByteArray newArena;
+        newArena.reserve(int(live));
+        quint32 userMask = quint32(newUsers.size()) - 1;
+        quint32 newUserCount = 0;
+        for (const UserSlot &slot : qAsConst(mappedUsers))
+        {
+            quint32 i = quint32(home(slot)) & userMask;
+            while (!isEmpty(newUsers[int(i)]) && newUsers[int(i)].user != slot.user)
+            {
+                i = (i + 1) & userMask;
+            }
+            if (!isEmpty(newUsers[int(i)]))
+            {
+                continue;
+            }
+            newUsers[int(i)] = { slot.user, quint32(newArena.size()), slot.size };
+            newArena.append(arena + slot.offset, int(slot.size));
+            ++newUserCount;
+        }
+
+        ownTokens = QVector<TokenSlot>(int(capacityFor(tokenSlots)));
+        quint32 tokenMask = quint32(ownTokens.size()) - 1;
+        for (quint32 i = 0; i < tokenCapacity; ++i)
+        {
+            if (isEmpty(tokens[i]))
+            {
+                continue;
+            }
+            quint32 j = quint32(home(tokens[i])) & tokenMask;
+            while (!isEmpty(ownTokens[int(j)]))
+            {
+                j = (j + 1) & tokenMask;
+            }
+            ownTokens[int(j)] = tokens[i];
+        }
+
+        if (newUserCount != userCount || tokenSlots != tokenCount || live != arenaSize)
+        {
+            qCDebug(tokenRegistry) << "Repaired a token snapshot shard:" << newUserCount << "users,"
+                                   << tokenSlots << "tokens";
+        }
+
+        ownUsers.swap(newUsers);
+        ownArena.swap(newArena);
+        userCapacity = quint32(ownUsers.size());
+        userCount = newUserCount;
+        tokenCapacity = quint32(ownTokens.size());
+        tokenCount = tokenSlots;
+        garbage = 0;
+        mapped = false;
+        sync();
+    }
+
+    void compact()
+    {
+        QByteArray compacted;
+        compacted.reserve(ownArena.size() - int(garbage));
+        for (UserSlot &slot : ownUsers)
+        {
+            if (isEmpty(slot))
+            {
+                continue;
+            }
+            quint32 offset = quint32(compacted.size());
+            compacted.append(ownArena.constData() + slot.offset, int(slot.size));
+            slot.offset = offset;
+        }
+        ownArena.swap(compacted);
+        garbage = 0;
+        sync();
+    }
+
+    // Makes room to append needed bytes without the arena moving, so
+    // a list can be copied from within the arena to its end
+    bool reserveArena(int needed)
+    {
+        if (garbage > CompactThreshold && garbage * 2 > quint32(ownArena.size()))
+        {
+            compact();
+        }
+        qint64 total = qint64(ownArena.size()) + needed;
+        if (total > MaxArena && garbage > 0)
+        {
+            compact();
+            total = qint64(ownArena.size()) + needed;
+        }
+        if (total > MaxArena)
+        {
+            qCWarning(tokenRegistry) << "Token registry shard is full";
+            return false;
+        }
+        if (total > ownArena.capacity())
+        {
+            ownArena.reserve(int(qMin(MaxArena, qMax(total, qint64(ownArena.size()) * 2))));
+            sync();
+        }
+        return true;
+    }
+
+    void addTokenIndex(quint64 hash, qint64 user)
+    {
+        if ((tokenCount + 1) * 10 > tokenCapacity * 7)
+        {
+            ownTokens = rehash(tokens, tokenCapacity, tokenCapacity ? tokenCapacity * 2 : MinCapacity);
+            tokenCapacity = quint32(ownTokens.size());
+            sync();
+        }
+        TokenSlot *slots = ownTokens.data();
+        quint32 mask = tokenCapacity - 1;
+        quint32 i = quint32(hash) & mask;
+        while (!isEmpty(slots[i]))
+        {
+            i = (i + 1) & mask;
+        }
+        slots[i] = { hash, user };
+        ++tokenCount;
+    }
+
+    void removeTokenIndex(quint64 hash, qint64 user)
+    {
+        if (tokenCapacity == 0)
+        {
+            return;
+        }
+        TokenSlot *slots = ownTokens.data();
+        quint32 mask = tokenCapacity - 1;
+        for (quint32 i = quint32(hash) & mask; !isEmpty(slots[i]); i = (i + 1) & mask)
+        {
+            if (slots[i].hash == hash && slots[i].user == user)
+            {
+                eraseAt(slots, tokenCapacity, i);
+                --tokenCount;
+                return;
+            }
+        }
+    }
+
+    // Users with a token of this hash; collisions are sorted out by
+    // remove(), which compares the token itself
+    QVector<qint64> usersWithHash(quint64 hash) const
+    {
+        QVector<qint64> found;
+        if (tokenCapacity == 0)
+        {
+            return found;
+        }
+        quint32 mask = tokenCapacity - 1;
+        quint32 i = quint32(hash) & mask;
+        for (quint32 n = 0; n < tokenCapacity && !isEmpty(tokens[i]); ++n, i = (i + 1) & mask)
+        {
+            if (tokens[i].hash == hash)
+            {
+                found.append(tokens[i].user);
+            }
+        }
+        return found;
+    }
+
+    bool insert(qint64 user, const QByteArray &token)
+    {
+        int index = findUser(user);
+        if (index >= 0 && findToken(users[index], token) >= 0)
+        {
+            return false;
+        }
+
+        if (mapped)
+        {
+            detach();
+            index = findUser(user);
+        }
+        int entry = int(sizeof(quint16)) + token.size();
+        if (!reserveArena(entry + (index >= 0 ? int(users[index].size) : 0)))
+        {
+            return false;
+        }
+
+        if (index < 0)
+        {
+            if ((userCount + 1) * 10 > userCapacity * 7)
+            {
+                ownUsers = rehash(users, userCapacity, userCapacity ? userCapacity * 2 : MinCapacity);
+                userCapacity = quint32(ownUsers.size());
+                sync();
+            }
+            quint32 mask = userCapacity - 1;
+            quint32 i = quint32(mix(quint64(user))) & mask;
+            while (!isEmpty(users[i]))
+            {
+                i = (i + 1) & mask;
+            }
+            index = int(i);
+            ownUsers[index] = { user, quint32(ownArena.size()), 0 };
+            ++userCount;
+        }
+
+        // A list grows in place at the end of the arena; anywhere else it
+        // moves there first, which the reservation above left room for
+        UserSlot &slot = ownUsers[index];
+        if (slot.size > 0 && slot.offset + slot.size != quint32(ownArena.size()))
+        {
+            quint32 from = slot.offset;
+            slot.offset = quint32(ownArena.size());
+            ownArena.append(ownArena.constData() + from, int(slot.size));
+            garbage += slot.size;
+        }
+        quint16 length = quint16(token.size());
+        ownArena.append(reinterpret_cast<const char *>(&length), sizeof(length));
+        ownArena.append(token);
+        slot.size += quint32(entry);
+
+        addTokenIndex(tokenHash(token.constData(), token.size()), user);
+        sync();
+        return true;
+    }
+
+    bool remove(qint64 user, const QByteArray &token)
+    {
+        int index = findUser(user);
+        qint64 at = index >= 0 ? findToken(users[index], token) : -1;
+        if (at < 0)
+        {
+            return false;
+        }
+
+        if (mapped)
+        {
+            detach();
+            index = findUser(user);
+            at = index >= 0 ? findToken(users[index], token) : -1;
+            if (at < 0)
+            {
+                return false;
+            }
+        }
+
+        // Close the gap inside the list; the freed tail is garbage
+        UserSlot &slot = ownUsers[index];
+        quint32 entry = quint32(sizeof(quint16) + token.size());
+        quint32 end = slot.offset + slot.size;
+        char *base = ownArena.data();
+        memmove(base + at, base + at + entry, size_t(end - quint32(at) - entry));
+        slot.size -= entry;
+        garbage += entry;
+        if (slot.size == 0)
+        {
+            eraseAt(ownUsers.data(), userCapacity, quint32(index));
+            --userCount;
+        }
+
+        removeTokenIndex(tokenHash(token.constData(), token.size()), user);
+        sync();
+        return true;
+    }
+
+    void removeUser(qint64 user)
+    {
+        int index = findUser(user);
+        if (index < 0)
+        {
+            return;
+        }
+
+        QVector<quint64> hashes;
+        forEachToken(users[index], [&](const char *, const char *data, int size) {
+            hashes.append(tokenHash(data, size));
+            return true;
+        });
+
+        if (mapped)
+        {
+            detach();
+            index = findUser(user);
+            if (index < 0)
+            {
+                return;
+            }
+        }
+        for (quint64 hash : qAsConst(hashes))
+        {
+            removeTokenIndex(hash, user);
+        }
+        garbage += ownUsers[index].size;
+        eraseAt(ownUsers.data(), userCapacity, quint32(index));
+        --userCount;
+        sync();
+    }
+};
+
+TokenRegistry::TokenRegistry(int shards)
+{
+    reset(shards);
+}
+
+TokenRegistry::~TokenRegistry()
+{
+    // The shards may point into the mapping
+    m_shards.reset();
+    unmap();
+}
+
+void TokenRegistry::reset(int shards)
+{
+    int count = 1;
+    while (count < qBound(1, shards, MaxShards))
+    {
+        count *= 2;
+    }
+
+    m_shards.reset(new Shard[size_t(count)]);
+    m_shardCount = count;
+    m_shardShift = 64;
+    for (int n = count; n > 1; n /= 2)
+    {
+        --m_shardShift;
+    }
+}
+
+void TokenRegistry::unmap()
+{
+    if (m_map)
+    {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+    m_file.close();
+}
+
+TokenRegistry::Shard &TokenRegistry::shardOf(qint64 user) const
+{
+    quint64 hash = mix(quint64(user));
+    return m_shards[m_shardShift < 64 ? size_t(hash >> m_shardShift) : 0];
+}
+
+bool TokenRegistry::insert(qint64 user, const QByteArray &token)
+{
+    if (token.isEmpty() || token.size() > MaxTokenLength)
+    {
+        return false;
+    }
+    Shard &shard = shardOf(user);
+    QWriteLocker locker(&shard.lock);
+    return shard.insert(user, token);
+}
+
+bool TokenRegistry::remove(qint64 user, const QByteArray &token)
+{
+    Shard &shard = shardOf(user);
+    QWriteLocker locker(&shard.lock);
+    return shard.remove(user, token);
+}
+
+void TokenRegistry::removeUser(qint64 user)
+{
+    Shard &shard = shardOf(user);
+    QWriteLocker locker(&shard.lock);
+    shard.removeUser(user);
+}
+
+int TokenRegistry::removeToken(const QByteArray &token)
+{
+    quint64 hash = tokenHash(token.constData(), token.size());
+    int removed = 0;
+    for (int i = 0; i < m_shardCount; ++i)
+    {
+        Shard &shard = m_shards[size_t(i)];
+        QVector<qint64> users;
+        {
+            QReadLocker locker(&shard.lock);
+            users = shard.usersWithHash(hash);
+        }
+        if (users.isEmpty())
+        {
+            continue;
+        }
+
+        QWriteLocker locker(&shard.lock);
+        for (qint64 user : qAsConst(users))
+        {
+            if (shard.remove(user, token))
+            {
+                ++removed;
+            }
+        }
+    }
+
+    if (removed > 0)
+    {
+        qCDebug(tokenRegistry) << "Removed token" << token.left(10) << "from" << removed << "users";
+    }
+    return removed;
+}
+
+int TokenRegistry::lookup(qint64 user, QVector<QByteArray> &out) const
+{
+    const Shard &shard = shardOf(user);
+    QReadLocker locker(&shard.lock);
+
+    int index = shard.findUser(user);
+    if (index < 0)
+    {
+        return 0;
+    }
+    int count = 0;
+    shard.forEachToken(shard.users[index], [&](const char *, const char *data, int size) {
+        out.append(QByteArray(data, size));
+        ++count;
+        return true;
+    });
+    return count;
+}
+
+QVector<QByteArray> TokenRegistry::tokens(qint64 user) const
+{
+    QVector<QByteArray> out;
+    lookup(user, out);
+    return out;
+}
+
+qint64 TokenRegistry::userCount() const
+{
+    qint64 count = 0;
+    for (int i = 0; i < m_shardCount; ++i)
+    {
+        QReadLocker locker(&m_shards[size_t(i)].lock);
+        count += m_shards[size_t(i)].userCount;
+    }
+    return count;
+}
+
+qint64 TokenRegistry::tokenCount() const
+{
+    qint64 count = 0;
+    for (int i = 0; i < m_shardCount; ++i)
+    {
+        QReadLocker locker(&m_shards[size_t(i)].lock);
+        count += m_shards[size_t(i)].tokenCount;
+    }
+    return count;
+}
+
+void TokenRegistry::clear()
+{
+    reset(m_shardCount);
+    unmap();
+}
+
+void TokenRegistry::pruneFrom(PushSender *sender)
+{
+    QObject::connect(sender, &PushSender::failed, sender,
+                     [this](const QByteArray &token, int status, const QByteArray &body) {
+                         if (isInvalidToken(status, body))
+                         {
+                             removeToken(token);
+                         }
+                     });
+}
+
+bool TokenRegistry::isInvalidToken(int status, const QByteArray &body)
+{
+    // Only what the service says about the token itself: a 404 from a
+    // wrong URL must not empty the registry
+    if (status == 410)
+    {
+        return true;
+    }
+    if (status / 100 != 4)
+    {
+        return false;
+    }
+    QString error = QJsonDocument::fromJson(body).object().value("error").toString();
+    return error == "unknown-token" || error == "invalid-token";
+}
+
+bool TokenRegistry::load(const QString &path)
+{
+    clear();
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly))
+    {
+        qCWarning(tokenRegistry) << "Cannot open token snapshot:" << path;
+        return false;
+    }
+
+    qint64 fileSize = m_file.size();
+    uchar *data = fileSize >= qint64(sizeof(Header)) ? m_file.map(0, fileSize) : nullptr;
+    if (!data)
+    {
+        qCWarning(tokenRegistry) << "Cannot map token snapshot:" << path;
+        m_file.close();
+        return false;
+    }
+
+    // Check every table against the file size before trusting an offset;
+    // the lists themselves are checked as they are read
+    Header header;
+    memcpy(&header, data, sizeof(header));
+    quint64 size = quint64(fileSize);
+    bool ok = memcmp(header.magic, Magic, sizeof(Magic)) == 0 && isPowerOfTwo(header.shardCount)
+              && header.shardCount <= quint32(MaxShards)
+              && sizeof(Header) + quint64(header.shardCount) * sizeof(ShardHeader) <= size;
+
+    if (ok)
+    {
+        reset(int(header.shardCount));
+        for (int i = 0; ok && i < m_shardCount; ++i)
+        {
+            ShardHeader entry;
+            memcpy(&entry, data + sizeof(Header) + size_t(i) * sizeof(ShardHeader), sizeof(entry));
+            ok = (entry.userCapacity == 0 || isPowerOfTwo(entry.userCapacity))
+                 && (entry.tokenCapacity == 0 || isPowerOfTwo(entry.tokenCapacity))
+                 && entry.userCount <= entry.userCapacity && entry.tokenCount <= entry.tokenCapacity
+                 && entry.usersOffset % 8 == 0 && entry.tokensOffset % 8 == 0
+                 && entry.usersOffset + quint64(entry.userCapacity) * sizeof(UserSlot) <= size
+                 && entry.tokensOffset + quint64(entry.tokenCapacity) * sizeof(TokenSlot) <= size
+                 && entry.arenaOffset + entry.arenaSize <= size && entry.arenaSize <= quint64(MaxArena);
+
+            Shard &shard = m_shards[size_t(i)];
+            shard.users = reinterpret_cast<const UserSlot *>(data + entry.usersOffset);
+            shard.tokens = reinterpret_cast<const TokenSlot *>(data + entry.tokensOffset);
+            shard.arena = reinterpret_cast<const char *>(data + entry.arenaOffset);
+            shard.userCapacity = entry.userCapacity;
+            shard.userCount = entry.userCount;
+            shard.tokenCapacity = entry.tokenCapacity;
+            shard.tokenCount = entry.tokenCount;
+            shard.arenaSize = entry.arenaSize;
+            shard.mapped = true;
+        }
+    }
+
+    if (!ok)
+    {
+        qCWarning(tokenRegistry) << "Ignoring malformed token snapshot:" << path;
+        reset(m_shardCount);
+        m_file.unmap(data);
+        m_file.close();
+        return false;
+    }
+
+    m_map = data;
+    qCDebug(tokenRegistry) << "Mapped token snapshot with" << header.userCount << "users and"
+                           << header.tokenCount << "tokens";
+    return true;
+}
+
+bool TokenRegistry::save(const QString &path) const
+{
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        qCWarning(tokenRegistry) << "Cannot write token snapshot:" << path;
+        return false;
+    }
+
+    // Lay out every shard first; arenas are written compacted, with only
+    // the lists their users point at
+    Header header;
+    memcpy(header.magic, Magic, sizeof(Magic));
+    header.shardCount = quint32(m_shardCount);
+    header.userCount = 0;
+    header.tokenCount = 0;
+
+    QVector<ShardHeader> entries(m_shardCount);
+    quint64 offset = align8(sizeof(Header) + quint64(m_shardCount) * sizeof(ShardHeader));
+    for (int i = 0; i < m_shardCount; ++i)
+    {
+        const Shard &shard = m_shards[size_t(i)];
+        quint64 live = 0;
+        for (quint32 j = 0; j < shard.userCapacity; ++j)
+        {
+            live += shard.users[j].size;
+        }
+
+        ShardHeader &entry = entries[i];
+        entry.userCapacity = shard.userCapacity;
+        entry.userCount = shard.userCount;
+        entry.tokenCapacity = shard.tokenCapacity;
+        entry.tokenCount = shard.tokenCount;
+        entry.arenaSize = quint32(live);
+        entry.reserved = 0;
+        entry.usersOffset = offset;
+        offset += quint64(shard.userCapacity) * sizeof(UserSlot);
+        entry.tokensOffset = offset;
+        offset += quint64(shard.tokenCapacity) * sizeof(TokenSlot);
+        entry.arenaOffset = offset;
+        offset = align8(offset + live);
+
+        header.userCount += shard.userCount;
+        header.tokenCount += shard.tokenCount;
+    }
+
+    qint64 written = 0;
+    auto write = [&](const void *data, qint64 size) {
+        file.write(static_cast<const char *>(data), size);
+        written += size;
+    };
+    auto pad = [&]() {
+        static const char zeros[8] = {};
+        write(zeros, qint64(align8(quint64(written))) - written);
+    };
+
+    write(&header, sizeof(header));
+    write(entries.constData(), qint64(entries.size()) * qint64(sizeof(ShardHeader)));
+    pad();
+
+    for (int i = 0; i < m_shardCount; ++i)
+    {
+        const Shard &shard = m_shards[size_t(i)];
+
+        // Slots in place, pointing at their list in the compacted arena
+        QVector<UserSlot> users(int(shard.userCapacity));
+        quint32 next = 0;
+        for (quint32 j = 0; j < shard.userCapacity; ++j)
+        {
+            users[int(j)] = shard.users[j];
+            if (!isEmpty(users[int(j)]))
+            {
+                users[int(j)].offset = next;
+                next += users[int(j)].size;
+            }
+        }
+        write(users.constData(), qint64(users.size()) * qint64(sizeof(UserSlot)));
+        write(shard.tokens, qint64(shard.tokenCapacity) * qint64(sizeof(TokenSlot)));
+
+        // A list that is out of bounds in a mapped snapshot is written as
+        // zeros, which reads back as no tokens
+        for (quint32 j = 0; j < shard.userCapacity; ++j)
+        {
+            const UserSlot &slot = shard.users[j];
+            if (isEmpty(slot))
+            {
+                continue;
+            }
+            if (quint64(slot.offset) + slot.size <= shard.arenaSize)
+            {
+                write(shard.arena + slot.offset, slot.size);
+            }
+            else
+            {
+                write(QByteArray(int(slot.size), '\0').constData(), slot.size);
+            }
+        }
+        pad();
+    }
+
+    if (!file.commit())
+    {
+        qCWarning(tokenRegistry) << "Cannot write token snapshot:" << path << file.errorString();
+        return false;
+    }
+
+    qCDebug(tokenRegistry) << "Wrote token snapshot with" << header.userCount << "users and"
+                           << header.tokenCount << "tokens";
+    return true;
+}
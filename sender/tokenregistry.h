@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2025 Suraj Yadav
+ *
+ * TokenRegistry - Sharded in-memory map from user id to device push
+ * tokens, with a snapshot file that is memory-mapped on load
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QReadWriteLock>
+#include <QString>
+#include <QVector>
+
+#include <memory>
+
+class PushSender;
+
+// Users are spread over a power-of-two number of shards, each behind its
+// own lock. A shard keeps its users in an open-addressing table of 16-byte
+// slots pointing into one arena where each user's tokens lie back to back,
+// so a lookup touches a slot or two and one contiguous list. A second
+// table maps token hashes to users, for pruning by token alone.
+//
+// load() maps a snapshot and uses its tables in place, so startup costs
+// no more than validating the shard table; reads of a mapped shard are
+// bounds-checked. A shard is checked slot by slot and copied to the heap
+// the first time it changes. Neither load() nor save() may run while other
+// threads use the registry.
+//
+// Snapshot layout, in host byte order:
+//   header   magic "TOK1", shard count, user count, token count
+//   shards   per shard: offsets of its user table, token table and arena,
+//            their capacities and counts, and the arena size
+//   per shard, 8-byte aligned:
+//     users   { qint64 user, quint32 offset, quint32 size }[capacity]
+//     tokens  { quint64 token hash, qint64 user }[capacity]
+//     arena   per user: { quint16 length, token bytes }...
+class TokenRegistry
+{
+public:
+    static const int DefaultShards = 64;
+
+    // shards is rounded up to a power of two
+    explicit TokenRegistry(int shards = DefaultShards);
+    ~TokenRegistry();
+
+    // Returns false if the user already had the token, or it is empty or
+    // longer than 65535 bytes
+    bool insert(qint64 user, const QByteArray &token);
+    bool remove(qint64 user, const QByteArray &token);
+    void removeUser(qint64 user);
+
+    // Removes the token from every user that has it and returns how many
+    // did. This checks every shard, so it is for the rare invalid token.
+    int removeToken(const QByteArray &token);
+
+    // Appends the user's tokens to out and returns how many there were
+    int lookup(qint64 user, QVector<QByteArray> &out) const;
+    QVector<QByteArray> tokens(qint64 user) const;
+
+    qint64 userCount() const;
+    qint64 tokenCount() const;
+    void clear();
+
+    // Removes tokens the push service refuses as unknown or invalid as
+    // the sender reports them. The registry must outlive the sender.
+    void pruneFrom(PushSender *sender);
+    static bool isInvalidToken(int status, const QByteArray &body);
+
+    // Replaces the contents with the snapshot at path; on failure the
+    // registry is left empty
+    bool load(const QString &path);
+
+    // Atomically replaces the snapshot at path
+    bool save(const QString &path) const;
+
+private:
+    Q_DISABLE_COPY(TokenRegistry)
+
+    struct Shard;
+
+    Shard &shardOf(qint64 user) const;
+    void reset(int shards);
+    void unmap();
+
+    std::unique_ptr<Shard[]> m_shards;
+    int m_shardCount = 0;
+    int m_shardShift = 0;
+
+    QFile m_file;
+    uchar *m_map = nullptr;
+};
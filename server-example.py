@@ -7,11 +7,13 @@ This script demonstrates how to integrate with Lomiri Push Service
 to send notifications to your app.
 """
 
+import base64
 import json
 import requests
 import argparse
+import struct
 import time
-from datetime import datetime, timedelta
+from datetime import datetime, timedelta, timezone
 
 class LomiriPushClient:
     def __init__(self, app_id, auth_token=None):
@@ -32,15 +34,23 @@ class LomiriPushClient:
             options = {}
             
         # Default notification options
-        expire_time = datetime.now() + timedelta(hours=24)
+        expire_time = datetime.utcnow() + timedelta(hours=24)
+        expire_on = expire_time.isoformat() + "Z"
+        
+        # The helper only sees "data"; repeat the expiry there so it can
+        # drop messages that expired while the device was offline
+        if options.get("cbor"):
+            data = to_cbor(message_data, expire_time)
+        else:
+            data = dict(message_data, expire_on=expire_on)
         
         payload = {
             "appid": self.app_id,
-            "expire_on": expire_time.isoformat() + "Z",
+            "expire_on": expire_on,
             "token": device_token,
             "clear_pending": options.get("clear_pending", True),
             "replace_tag": options.get("replace_tag"),
-            "data": message_data
+            "data": data
         }
         
         headers = {
@@ -78,6 +88,7 @@ def create_text_message(sender, message, chat_id, badge_count=1):
             "loc_key": "MESSAGE_TEXT",
             "loc_args": [sender, message],
             "badge": badge_count,
+            "date": int(time.time()),
             "custom": {
                 "from_id": str(chat_id)
             }
@@ -91,6 +102,7 @@ def create_photo_message(sender, chat_id, badge_count=1):
             "loc_key": "MESSAGE_PHOTO",
             "loc_args": [sender],
             "badge": badge_count,
+            "date": int(time.time()),
             "custom": {
                 "from_id": str(chat_id)
             }
@@ -104,6 +116,7 @@ def create_group_message(sender, group_name, message, chat_id, badge_count=1):
             "loc_key": "CHAT_MESSAGE_TEXT",
             "loc_args": [sender, group_name, message],
             "badge": badge_count,
+            "date": int(time.time()),
             "custom": {
                 "chat_id": str(chat_id)
             }
@@ -117,12 +130,80 @@ def create_group_invite(sender, group_name, chat_id, badge_count=1):
             "loc_key": "CHAT_ADD_YOU",
             "loc_args": [sender, group_name],
             "badge": badge_count,
+            "date": int(time.time()),
             "custom": {
                 "chat_id": str(chat_id)
             }
         }
     }
 
+# Integer keys of the compact CBOR payload, see PushCbor in push/pushmessage.h
+CBOR_PAYLOAD_KEYS = {"message": 0, "messages": 1, "expire_on": 2}
+CBOR_MESSAGE_KEYS = {"loc_key": 0, "loc_args": 1, "badge": 2, "custom": 3, "date": 4}
+CBOR_CUSTOM_KEYS = {"from_id": 0, "chat_id": 1, "channel_id": 2, "id": 3}
+
+def _cbor_head(major, value):
+    if value < 24:
+        return bytes([major << 5 | value])
+    for info, fmt in ((24, ">B"), (25, ">H"), (26, ">I"), (27, ">Q")):
+        if value < 1 << (8 * struct.calcsize(fmt)):
+            return bytes([major << 5 | info]) + struct.pack(fmt, value)
+    raise ValueError("integer too large for CBOR")
+
+def encode_cbor(value):
+    """Encode ints, strings, lists and dicts as CBOR"""
+    if isinstance(value, bool):
+        return b"\xf5" if value else b"\xf4"
+    if isinstance(value, int):
+        return _cbor_head(0, value) if value >= 0 else _cbor_head(1, -1 - value)
+    if isinstance(value, str):
+        text = value.encode("utf-8")
+        return _cbor_head(3, len(text)) + text
+    if isinstance(value, (list, tuple)):
+        return _cbor_head(4, len(value)) + b"".join(encode_cbor(item) for item in value)
+    if isinstance(value, dict):
+        return _cbor_head(5, len(value)) + b"".join(
+            encode_cbor(key) + encode_cbor(item) for key, item in value.items())
+    raise TypeError(f"cannot encode {type(value).__name__} as CBOR")
+
+def _cbor_message(message):
+    packed = {}
+    for key, value in message.items():
+        if key == "custom":
+            value = {CBOR_CUSTOM_KEYS[k]: int(v) if str(v).lstrip("-").isdigit() else v
+                     for k, v in value.items() if k in CBOR_CUSTOM_KEYS}
+        if key in CBOR_MESSAGE_KEYS:
+            packed[CBOR_MESSAGE_KEYS[key]] = value
+    return packed
+
+def to_cbor(message_data, expire_time=None):
+    """Compact CBOR form of a payload with integer keys.
+
+    The push service only carries JSON, so the result goes base64-encoded
+    into the "cbor" member of the data; the helper detects it.
+    """
+    packed = {}
+    if "message" in message_data:
+        packed[CBOR_PAYLOAD_KEYS["message"]] = _cbor_message(message_data["message"])
+    if "messages" in message_data:
+        packed[CBOR_PAYLOAD_KEYS["messages"]] = [_cbor_message(m) for m in message_data["messages"]]
+    if expire_time is not None:
+        packed[CBOR_PAYLOAD_KEYS["expire_on"]] = int(expire_time.replace(tzinfo=timezone.utc).timestamp())
+    return {
+        "cbor": base64.b64encode(encode_cbor(packed)).decode("ascii")
+    }
+
+def pack_messages(message_datas):
+    """Pack several message notifications into one push payload.
+
+    The helper renders every event and posts one card per chat, so a
+    burst costs one push instead of one per message. Keep the result
+    under the push service's payload size limit.
+    """
+    return {
+        "messages": [data["message"] for data in message_datas]
+    }
+
 def main():
     parser = argparse.ArgumentParser(description="Send Ubuntu Touch push notifications")
     parser.add_argument("--app-id", required=True, help="Application ID")
@@ -136,6 +217,8 @@ def main():
     parser.add_argument("--chat-id", type=int, default=123456789, help="Chat ID")
     parser.add_argument("--badge", type=int, default=1, help="Badge count")
     parser.add_argument("--demo", action="store_true", help="Run demo with sample messages")
+    parser.add_argument("--packed", action="store_true", help="Send the demo messages as one push")
+    parser.add_argument("--cbor", action="store_true", help="Send the compact CBOR payload format")
     
     args = parser.parse_args()
     
@@ -153,9 +236,16 @@ def main():
             ("Group Invite", create_group_invite("Dave", "Book Club", 901234, 4))
         ]
         
+        if args.packed:
+            print("\n--- Sending all demo messages in one push ---")
+            client.send_notification(args.token, pack_messages([data for _, data in messages]),
+                                     {"replace_tag": f"demo_{int(time.time())}", "cbor": args.cbor})
+            return
+        
         for name, message_data in messages:
             print(f"\n--- Sending {name} ---")
-            client.send_notification(args.token, message_data, {"replace_tag": f"demo_{int(time.time())}"})
+            client.send_notification(args.token, message_data,
+                                     {"replace_tag": f"demo_{int(time.time())}", "cbor": args.cbor})
             time.sleep(2)  # Delay between messages
             
     else:
@@ -175,7 +265,7 @@ def main():
                 return
             message_data = create_group_invite(args.sender, args.group, args.chat_id, args.badge)
         
-        client.send_notification(args.token, message_data, {"replace_tag": f"msg_{args.chat_id}"})
+        client.send_notification(args.token, message_data, {"replace_tag": f"msg_{args.chat_id}", "cbor": args.cbor})
 
 if __name__ == "__main__":
     main()